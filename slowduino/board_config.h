@@ -26,6 +26,20 @@
 #endif
 //#define BOARD_SPEEDUINO_V04  // Speeduino v0.4 (Arduino Mega, 4 canais, 1-8 cilindros)
 
+// ============================================================================
+// ENTRADA DO TRIGGER
+// ============================================================================
+//
+// Padrão: o trigger entra por interrupção externa (INT0/INT2) e o timestamp do
+// dente é lido em software dentro da ISR - carrega o atraso de qualquer outra
+// ISR que estivesse rodando quando a borda chegou.
+//
+// Com TRIGGER_USE_ICP1 o sinal entra no pino de input capture do Timer1 (ICP1,
+// D8 no Uno/Nano): o hardware copia o TCNT1 para o ICR1 no instante da borda,
+// e o decoder usa esse valor. Só existe no Uno/Nano (no Mega o ICP1 não sai
+// em nenhum pino). Também pode ser definido por build flag (-DTRIGGER_USE_ICP1).
+//#define TRIGGER_USE_ICP1
+
 // ============================================================================
 // DETECÇÃO AUTOMÁTICA DE PLACA (se nenhuma foi definida)
 // ============================================================================
@@ -42,6 +56,9 @@
   #if !defined(__AVR_ATmega2560__) && !defined(__AVR_ATmega1280__)
     #error "BOARD_SPEEDUINO_V04 requer Arduino Mega (ATmega2560/1280)"
   #endif
+  #if defined(TRIGGER_USE_ICP1)
+    #error "TRIGGER_USE_ICP1: o ICP1 (PD4) não está ligado a nenhum pino do Arduino Mega"
+  #endif
 #endif
 
 #if defined(BOARD_SLOWDUINO)
@@ -66,7 +83,7 @@
 
   // Entradas Digitais (Trigger)
   #define PIN_TRIGGER_PRIMARY   19  // Crank Input (VR1+) - INT2
-  // PIN_TRIGGER_SECONDARY não usado (sem sensor de fase no Slowduino)
+  #define PIN_TRIGGER_SECONDARY 18  // Cam Input (VR2+) - INT3, sensor de fase (opcional)
 
   // Saídas Digitais - Injeção (2 bancos + auxiliar)
   // Speeduino v0.4 usa drivers duplos (1/2 e 2/2 para cada canal)
@@ -105,8 +122,7 @@
   #define PIN_FUEL_PRESSURE A7   // Pressão combustível (adaptação, não padrão v0.4)
 
   // Capacidades da placa (limitadas pelo firmware Slowduino)
-  // #undef BOARD_HAS_SECONDARY_TRIGGER  (não usado)
-  // #undef BOARD_SUPPORTS_SEQUENTIAL    (não implementado)
+  // Sequencial: 1 injetor por cilindro só até 2 cilindros (2 canais principais)
 
 // ============================================================================
 // CONFIGURAÇÃO: SLOWDUINO (Arduino Uno/Nano)
@@ -120,13 +136,16 @@
   #define BOARD_IGN_CHANNELS  2
 
   // Entradas Digitais (TRIGGER PRECISA DE INT0 - SOMENTE D2 NO UNO/NANO!)
-  #define PIN_TRIGGER_PRIMARY   2   // Sensor de rotação (crank) - INT0 (D2)
-  // NOTA: PIN_TRIGGER_SECONDARY (D3) REMOVIDO - sem sensor de fase (wasted spark 2 canais)
+  #if defined(TRIGGER_USE_ICP1)
+    #define PIN_TRIGGER_PRIMARY 8   // Sensor de rotação (crank) - ICP1 (D8 = PB0)
+  #else
+    #define PIN_TRIGGER_PRIMARY 2   // Sensor de rotação (crank) - INT0 (D2)
+  #endif
+  #define PIN_TRIGGER_SECONDARY 3   // Sensor de fase (cam) - INT1 (D3), opcional
 
   // Saídas Digitais - Ignição (wasted spark para motores 1-4 cilindros)
   #define PIN_IGNITION_1      4   // Ignição 1 (cilindros 1+4)
   #define PIN_IGNITION_2      5   // Ignição 2 (cilindros 2+5)
-  // D3 fica disponível (ex: ign kill, tach, auxiliar)
 
   // Saídas Digitais - Injeção (2 bancos principais + canal auxiliar)
   #define PIN_INJECTOR_1     10   // Bico 1 (cilindros 1+4)
@@ -135,14 +154,18 @@
 
   // Saídas Digitais - Auxiliares
   #define PIN_FUEL_PUMP       6   // Relé da bomba de combustível
-  #define PIN_FAN             8   // Ventoinha do radiador
+  #if defined(TRIGGER_USE_ICP1)
+    #define PIN_FAN           2   // Ventoinha do radiador (D8 virou entrada do trigger)
+  #else
+    #define PIN_FAN           8   // Ventoinha do radiador
+  #endif
   #define PIN_IDLE_VALVE      9   // Selenoide de marcha lenta (IAC - PWM) = PB1
 
   // ATENÇÃO: D9 é OC1A. NUNCA usar analogWrite() neste pino!
   // analogWrite(9, v) do core Arduino faz sbi(TCCR1A, COM1A1) e escreve
   // OCR1A = v - e OCR1A é o compare absoluto que o scheduler usa para
-  // agendar a ignição/injeção do canal 1 (scheduler.cpp). Isso destrói o
-  // timing de faísca. O PWM do IAC é gerado por software na ISR do Timer2
+  // disparar o próximo evento da fila de ignição/injeção (scheduler.cpp).
+  // Isso destrói o timing de faísca. O PWM do IAC é gerado por software na ISR do Timer2
   // (auxiliaries.cpp), que não toca em nenhum registrador do Timer1.
   #define IDLE_PIN_HIGH()     (PORTB |= (1 << PB1))
   #define IDLE_PIN_LOW()      (PORTB &= ~(1 << PB1))
@@ -161,8 +184,7 @@
   #define PIN_FUEL_PRESSURE   A7   // Pressão da linha de combustível
 
   // Capacidades da placa
-  // #undef BOARD_HAS_SECONDARY_TRIGGER  (não definido)
-  // #undef BOARD_SUPPORTS_SEQUENTIAL    (não definido)
+  // Sequencial: 1 injetor por cilindro só até 2 cilindros (2 canais principais)
 
 #endif
 
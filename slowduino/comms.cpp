@@ -6,6 +6,9 @@
 #include "comms.h"
 #include "storage.h"
 #include "tables.h"
+#include "scheduler.h"
+#include "fuel.h"
+#include "decoders.h"
 
 // ============================================================================
 // TABELA CRC32
@@ -78,14 +81,140 @@ static_assert(sizeof(ConfigPage2) >= 128, "ConfigPage2 precisa ter 128 bytes");
 
 // Buffer serial
 static uint8_t serialBuffer[SERIAL_BUFFER_SIZE];
-static uint8_t serialBytesReceived = 0;
+static uint16_t serialBytesReceived = 0;
 static bool modernProtocol = false;
-// uint16_t -> uint8_t: nunca precisa guardar mais que SERIAL_BUFFER_SIZE-6
-// (58 hoje), que cabe à vontade em 8 bits. O valor CRU de 16 bits lido do
-// header (que pode chegar a 65535 se alguém mandar lixo) é validado ANTES
-// de gravar aqui - ver o parse do header em commsProcess(), que usa uma
-// variável local mais larga só para a validação.
-static uint8_t expectedLength = 0;
+// Tamanho do payload lido do header (big-endian). Até SERIAL_BUFFER_SIZE-6
+// o frame inteiro fica no serialBuffer; acima disso só 'M' é aceito, em
+// streaming (ver frameStreaming), até PAGE_CMD_HEADER + PAGE_STAGING_SIZE.
+static uint16_t expectedLength = 0;
+// CRC32 do payload, acumulado byte a byte durante a recepção
+static uint32_t frameCRC = 0;
+// Frame maior que o serialBuffer: o cabeçalho do 'M' e o CRC ficam no
+// serialBuffer, os dados vão para pageStaging e só são aplicados à página
+// depois que o CRC confere.
+static bool frameStreaming = false;
+
+// Área de staging dos 'M' grandes
+static uint8_t pageStaging[PAGE_STAGING_SIZE];
+
+// 'M' + CAN_ID + página + offset(2) + length(2)
+static constexpr uint8_t PAGE_CMD_HEADER = 7;
+
+// Resposta grande em andamento (ver TRANSMISSÃO NÃO-BLOQUEANTE)
+enum TxSource : uint8_t {
+  TX_IDLE,     // Nada pendente
+  TX_REALTIME, // Offset byte + log entries do snapshot publicado
+  TX_PAGE,     // Corpo lido da página byte a byte (readPageByte)
+  TX_TOOTHLOG  // Corpo gerado do tooth log registro a registro
+};
+
+static struct {
+  uint8_t source;     // TxSource
+  bool framed;        // Modern: [length][RC_OK][corpo][CRC32]; legacy: só o corpo
+  uint8_t page;       // Página (TX_PAGE) ou buffer do snapshot (TX_REALTIME)
+  uint16_t offset;    // Primeiro byte do corpo
+  uint16_t length;    // Bytes do corpo
+  uint16_t position;  // Próximo byte da resposta inteira
+  uint32_t crc;       // CRC32 acumulado de RC_OK + corpo
+  uint32_t record;    // TX_TOOTHLOG: gap ou refTime do registro atual
+  uint8_t flags;      // TX_TOOTHLOG: flags do registro atual (composite)
+} txStream;
+
+// Snapshot do realtime: só os log entries que o Slowduino preenche, já
+// codificados como o TunerStudio lê e na ordem do pacote Speeduino (AVR é
+// little-endian, então os uint16_t já estão no formato do fio). Os trechos
+// contíguos do pacote estão em outputRuns; o resto do pacote é zero.
+struct OutputChannels {
+  // Log entries 0-15
+  uint8_t  secl;            // 0
+  uint8_t  status1;         // 1: running, toothLog1Ready (0x40), burnPending (0x80)
+  uint8_t  engine;          // 2
+  uint8_t  syncLoss;        // 3
+  uint16_t MAP;             // 4-5: kPa * 10
+  uint8_t  IAT;             // 6: °C + 40
+  uint8_t  coolant;         // 7: °C + 40
+  uint8_t  batCorrection;   // 8
+  uint8_t  battery10;       // 9
+  uint8_t  O2;              // 10
+  uint8_t  egoCorrection;   // 11: sem correção O2 ainda (100)
+  uint8_t  iatCorrection;   // 12: 100
+  uint8_t  wueCorrection;   // 13
+  uint16_t RPM;             // 14-15
+  // Log entries 24-29
+  uint8_t  advance;         // 24: graus + 40 (permite negativos)
+  uint8_t  TPS;             // 25: 0,5%
+  uint16_t loopsPerSec;     // 26-27
+  uint16_t freeRAM;         // 28-29
+  // Avulsos
+  uint8_t  spark;           // 32: bit 0 = sync
+  uint8_t  idleLoad;        // 38: duty da válvula de marcha lenta (%)
+  uint8_t  baro;            // 41: 100 kPa (atmosférico)
+  uint16_t PW1;             // 76-77 (us)
+  uint16_t PW2;             // 78-79
+  uint16_t PW3;             // 80-81
+  uint8_t  CLIdleTarget;    // 92: RPM / 10 (escala Speeduino)
+  uint8_t  VE;              // 102
+} __attribute__((packed));
+
+struct OutputRun {
+  uint8_t logOffset;  // Primeiro log entry do trecho
+  uint8_t length;     // Bytes do trecho (consecutivos em OutputChannels)
+};
+
+static const OutputRun outputRuns[] PROGMEM = {
+  {0, 16}, {24, 6}, {32, 1}, {38, 1}, {41, 1}, {76, 6}, {92, 1}, {102, 1}
+};
+
+static_assert(sizeof(OutputChannels) == 33, "OutputChannels deve somar os trechos de outputRuns");
+
+// Tamanho de cada campo de OutputChannels, na ordem da struct. O bit n da
+// máscara do datalog em push ('L') escolhe o campo n.
+static const uint8_t outputFieldSize[] PROGMEM = {
+  1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2,  // secl .. RPM
+  1, 1, 2, 2,                                // advance .. freeRAM
+  1, 1, 1, 2, 2, 2, 1, 1                     // spark .. VE
+};
+
+static constexpr uint8_t OUTPUT_FIELD_COUNT = sizeof(outputFieldSize);
+static_assert(OUTPUT_FIELD_COUNT < 32, "Máscara do datalog é uint32_t");
+static constexpr uint32_t OUTPUT_FIELDS_ALL = (1UL << OUTPUT_FIELD_COUNT) - 1;
+
+// Dois buffers: commsUpdateSnapshot() preenche o que não está publicado e
+// troca snapshotFront, então uma resposta nunca vê RPM/PW1/etc. pela metade.
+static OutputChannels outputSnapshot[2];
+static uint8_t snapshotFront = 0;
+
+// Datalog em push. Keyframe: [length BE] [SERIAL_RC_DATALOG] [seq] [tempo
+// ms (uint16 LE)] [máscara (uint32 LE)] [campos escolhidos] [CRC32 BE].
+// Delta: [length BE] [SERIAL_RC_DATALOG_DELTA] [seq] [seq de referência]
+// [tempo ms] [bitmap dos campos escolhidos que mudaram] [só esses campos]
+// [CRC32 BE], sempre contra o último frame efetivamente enviado.
+static constexpr uint8_t DATALOG_HEADER = 7;        // seq + tempo + máscara
+static constexpr uint8_t DATALOG_DELTA_HEADER = 4;  // seq + referência + tempo
+static uint8_t datalogRate = 0;      // Frames por segundo (0 = desligado)
+static uint16_t datalogPeriod = 0;   // ms entre frames (1000 a 1 Hz)
+static uint32_t datalogMask = 0;     // Bit n = campo n de OutputChannels
+static uint8_t datalogFields = 0;    // Campos escolhidos (bits em datalogMask)
+static uint8_t datalogLength = 0;    // Bytes de campos por keyframe
+static uint8_t datalogSeq = 0;       // Avança a cada período, enviado ou não
+static uint16_t lastDatalog = 0;     // millis() do último período
+static uint8_t datalogKeyInterval = 0;  // Deltas entre keyframes (0 = só keyframes)
+static uint8_t datalogSinceKey = 0;     // Deltas enviados desde o último keyframe
+static uint8_t datalogLastSeq = 0;      // seq do último frame enviado
+static uint8_t datalogLast[sizeof(OutputChannels)];  // Snapshot do último frame enviado
+
+// Frame inteiro precisa caber no buffer de TX do core (63 bytes livres)
+static_assert(2 + 1 + DATALOG_HEADER + sizeof(OutputChannels) + 4 <= 63, "Frame de datalog maior que o buffer de TX");
+static_assert(2 + 1 + DATALOG_DELTA_HEADER + 4 + sizeof(OutputChannels) + 4 <= 63, "Delta de datalog maior que o buffer de TX");
+
+static_assert(PAGE_CMD_HEADER + 4 <= SERIAL_BUFFER_SIZE - 2, "Cabeçalho do 'M' + CRC precisam caber no serialBuffer");
+
+// CRC32 de cada página, calculado no primeiro 'd' e invalidado só por
+// writePageValues(). O TunerStudio pede o CRC de todas as páginas a cada
+// conexão; sem cache, cada pedido percorria a página inteira via
+// readPageByte() (decodificando eixos e avanço byte a byte).
+static uint32_t pageCRCCache[PAGE_COUNT];
+static uint16_t pageCRCValid = 0;  // Bit n = pageCRCCache[n] válido
 
 // ============================================================================
 // CONSTANTES AUXILIARES PARA PÁGINAS SPEEDUINO
@@ -135,6 +264,7 @@ static inline uint16_t decodeRpmBin(uint8_t stored) {
 }
 
 static bool readPageByte(uint8_t page, uint16_t offset, uint8_t& value);
+static bool datalogConfigure(uint8_t rate, uint32_t mask, uint8_t keyInterval);
 static PageWriteStatus writePageByte(uint8_t page, uint16_t offset, uint8_t value);
 
 // ============================================================================
@@ -146,6 +276,8 @@ void commsInit() {
   serialBytesReceived = 0;
   modernProtocol = false;
   expectedLength = 0;
+  frameStreaming = false;
+  txStream.source = TX_IDLE;
 }
 
 // ============================================================================
@@ -187,11 +319,146 @@ void sendU32BE(uint32_t value) {
   Serial.write(value & 0xFF);
 }
 
+// ============================================================================
+// TRANSMISSÃO NÃO-BLOQUEANTE
+// ============================================================================
+// As respostas grandes (realtime, output channels, leitura de página) passam
+// de 128 bytes e o buffer de TX do core tem 64: Serial.write() ficava em
+// espera ativa (~6 ms a 115200) até a ISR UDRE do core esvaziar o buffer,
+// atrasando o resto do loop. Agora a resposta é registrada em txStream e
+// commsTransmit() entrega a cada volta do loop só o que cabe no buffer
+// (Serial.availableForWrite()); a ISR UDRE do core continua drenando.
+
+// Log entry 'entry' do snapshot 'buffer' (0 fora dos trechos preenchidos)
+static uint8_t outputChannelByte(uint8_t buffer, uint8_t entry) {
+  const uint8_t* snapshot = (const uint8_t*)&outputSnapshot[buffer];
+  uint8_t base = 0;
+
+  for (uint8_t i = 0; i < sizeof(outputRuns) / sizeof(outputRuns[0]); i++) {
+    uint8_t start = pgm_read_byte(&outputRuns[i].logOffset);
+    uint8_t length = pgm_read_byte(&outputRuns[i].length);
+    if (entry < start) break;
+    if (entry < start + length) return snapshot[base + (entry - start)];
+    base += length;
+  }
+  return 0;
+}
+
+// Byte 'index' do corpo da resposta
+static uint8_t txBodyByte(uint16_t index) {
+  if (txStream.source == TX_REALTIME) {
+    uint16_t position = txStream.offset + index;
+    // Byte 0: offset byte (compatibilidade Speeduino); depois os log entries
+    return (position == 0) ? 0x00 : outputChannelByte(txStream.page, position - 1);
+  }
+  if (txStream.source == TX_TOOTHLOG) {
+    // Registro: gap/refTime (4 bytes BE) [+ flags no composite]
+    bool composite = (toothLogMode == TOOTH_LOG_COMPOSITE);
+    uint8_t recordSize = composite ? 5 : 4;
+    uint8_t entry = index / recordSize;
+    uint8_t part = index % recordSize;
+
+    if (part == 0) {
+      uint16_t gap;
+      txStream.flags = toothLogEntry(entry, gap);
+      if (!composite) {
+        txStream.record = gap;
+      } else if (entry > 0) {
+        // Composite: o TunerStudio quer o tempo acumulado (refTime); a
+        // primeira entrada é a referência zero.
+        txStream.record += gap;
+      }
+    }
+    if (part == 4) {
+      return txStream.flags;
+    }
+    return (uint8_t)(txStream.record >> (24 - 8 * part));
+  }
+  uint8_t value = 0;
+  if (!readPageByte(txStream.page, txStream.offset + index, value)) {
+    value = 0;
+  }
+  return value;
+}
+
+// Entrega o que couber no buffer de TX sem bloquear
+static void commsTransmit() {
+  uint16_t bodyStart = txStream.framed ? 3 : 0;  // length(2) + RC_OK
+  uint16_t bodyEnd = bodyStart + txStream.length;
+  uint16_t total = txStream.framed ? (bodyEnd + 4) : bodyEnd;
+  int room = Serial.availableForWrite();
+
+  while (room > 0 && txStream.position < total) {
+    uint16_t position = txStream.position++;
+    uint8_t value;
+
+    if (position >= bodyStart && position < bodyEnd) {
+      value = txBodyByte(position - bodyStart);
+      txStream.crc = crc32Update(txStream.crc, value);
+    } else if (position == 0) {
+      value = (uint8_t)((txStream.length + 1) >> 8);  // Length BE (RC_OK + corpo)
+    } else if (position == 1) {
+      value = (uint8_t)(txStream.length + 1);
+    } else if (position == 2) {
+      value = SERIAL_RC_OK;
+      txStream.crc = crc32Update(txStream.crc, value);
+    } else {
+      // CRC32 big-endian
+      uint8_t shift = 8 * (3 - (position - bodyEnd));
+      value = (uint8_t)(~txStream.crc >> shift);
+    }
+
+    Serial.write(value);
+    room--;
+  }
+
+  if (txStream.position >= total) {
+    if (txStream.source == TX_TOOTHLOG) {
+      // Enviado: a ISR volta a capturar
+      toothLogRestart();
+    }
+    txStream.source = TX_IDLE;
+  }
+}
+
+// Registra uma resposta e já envia o que couber
+static void txStreamStart(uint8_t source, bool framed, uint8_t page, uint16_t offset, uint16_t length) {
+  txStream.source = source;
+  txStream.framed = framed;
+  txStream.page = page;
+  txStream.offset = offset;
+  txStream.length = length;
+  txStream.position = 0;
+  txStream.crc = 0xFFFFFFFF;
+  txStream.record = 0;
+  commsTransmit();
+}
+
 // ============================================================================
 // PROCESSAMENTO PRINCIPAL
 // ============================================================================
 
+// Prepara a recepção do próximo frame
+static void resetModernFrame() {
+  serialBytesReceived = 0;
+  expectedLength = 0;
+  frameStreaming = false;
+  modernProtocol = false;
+}
+
+// Bytes do payload guardados no serialBuffer (em streaming, só o cabeçalho)
+static inline uint8_t modernStoredLength() {
+  return frameStreaming ? PAGE_CMD_HEADER : (uint8_t)expectedLength;
+}
+
 void commsProcess() {
+  // Resposta anterior ainda saindo: o TunerStudio só manda o próximo comando
+  // depois de recebê-la.
+  if (txStream.source != TX_IDLE) {
+    commsTransmit();
+    return;
+  }
+
   if (!Serial.available()) {
     return;
   }
@@ -218,39 +485,54 @@ void commsProcess() {
   }
 
   // Modern Protocol: continua lendo
+  // [2-byte length] [payload] [4-byte CRC]
   if (modernProtocol) {
-    // Lê bytes disponíveis
-    while (Serial.available() && serialBytesReceived < SERIAL_BUFFER_SIZE) {
-      serialBuffer[serialBytesReceived++] = Serial.read();
-
-      // Leu o length header completo? (2 bytes)
-      if (serialBytesReceived == 2 && expectedLength == 0) {
-        // Length é big-endian. Parse num uint16_t local ANTES de validar -
-        // gravar direto em expectedLength (uint8_t) truncaria um valor
-        // grande demais e deixaria passar pela checagem de tamanho.
-        uint16_t parsedLength = ((uint16_t)serialBuffer[0] << 8) | serialBuffer[1];
-
-        // Valida tamanho
-        if (parsedLength > (SERIAL_BUFFER_SIZE - 6)) {
-          // Muito grande! Reset
-          serialBytesReceived = 0;
-          expectedLength = 0;
-          modernProtocol = false;
-          return;
+    while (Serial.available()) {
+      uint8_t value = Serial.read();
+      uint16_t position = serialBytesReceived++;
+
+      // Length header (2 bytes, big-endian)
+      if (position < 2) {
+        serialBuffer[position] = value;
+        if (position == 1) {
+          expectedLength = ((uint16_t)serialBuffer[0] << 8) | serialBuffer[1];
+
+          // Valida tamanho: lixo no header não pode virar índice de buffer
+          if (expectedLength == 0 || expectedLength > (PAGE_CMD_HEADER + PAGE_STAGING_SIZE)) {
+            resetModernFrame();
+            return;
+          }
+          frameStreaming = (expectedLength > (SERIAL_BUFFER_SIZE - 6));
+          frameCRC = 0xFFFFFFFF;
         }
+        continue;
+      }
 
-        expectedLength = (uint8_t)parsedLength;
+      uint16_t index = position - 2;  // Posição dentro do payload
+      if (index < expectedLength) {
+        frameCRC = crc32Update(frameCRC, value);
+
+        if (!frameStreaming || index < PAGE_CMD_HEADER) {
+          serialBuffer[position] = value;
+          // Só o 'M' tem motivo para passar do serialBuffer
+          if (frameStreaming && index == 0 && value != 'M') {
+            resetModernFrame();
+            return;
+          }
+        } else {
+          pageStaging[index - PAGE_CMD_HEADER] = value;
+        }
+        continue;
       }
 
-      // Recebeu mensagem completa? [2-byte length] [payload] [4-byte CRC]
-      if (expectedLength > 0 && serialBytesReceived >= (2 + expectedLength + 4)) {
-        // Processa comando modern
-        processModernCommand();
+      // CRC recebido: logo após o que ficou do payload no serialBuffer
+      uint8_t crcIndex = index - expectedLength;
+      serialBuffer[2 + modernStoredLength() + crcIndex] = value;
 
-        // Reset para próximo comando
-        serialBytesReceived = 0;
-        expectedLength = 0;
-        modernProtocol = false;
+      // Recebeu mensagem completa?
+      if (crcIndex == 3) {
+        processModernCommand();
+        resetModernFrame();
         return;
       }
     }
@@ -317,10 +599,7 @@ void processLegacyCommand(uint8_t command) {
 
 void sendRealtimeData() {
   // Legacy protocol: envia offset byte + 126 log entries = 127 bytes total
-  uint8_t buffer[LOG_ENTRY_SIZE];  // 127 bytes
-  buffer[0] = 0x00;  // Offset byte
-  buildRealtimePacket(&buffer[1]);  // Log entries após offset
-  sendBytes(buffer, LOG_ENTRY_SIZE);  // Envia 127 bytes
+  txStreamStart(TX_REALTIME, false, snapshotFront, 0, LOG_ENTRY_SIZE);  // 127 bytes, sem framing
 }
 
 void sendFirmwareVersion() {
@@ -350,14 +629,15 @@ void processModernCommand() {
   uint8_t* payload = &serialBuffer[2];
   uint16_t payloadLength = expectedLength;
 
-  // Extrai CRC recebido (últimos 4 bytes)
-  uint32_t receivedCRC = ((uint32_t)serialBuffer[2 + payloadLength] << 24) |
-                         ((uint32_t)serialBuffer[2 + payloadLength + 1] << 16) |
-                         ((uint32_t)serialBuffer[2 + payloadLength + 2] << 8) |
-                         ((uint32_t)serialBuffer[2 + payloadLength + 3]);
+  // Extrai CRC recebido (4 bytes após o payload guardado)
+  uint8_t* crcBytes = &serialBuffer[2 + modernStoredLength()];
+  uint32_t receivedCRC = ((uint32_t)crcBytes[0] << 24) |
+                         ((uint32_t)crcBytes[1] << 16) |
+                         ((uint32_t)crcBytes[2] << 8) |
+                         ((uint32_t)crcBytes[3]);
 
-  // Calcula CRC do payload
-  uint32_t calculatedCRC = calculateCRC32(payload, payloadLength);
+  // CRC do payload já foi acumulado durante a recepção
+  uint32_t calculatedCRC = ~frameCRC;
 
   // Valida CRC
   if (receivedCRC != calculatedCRC) {
@@ -376,15 +656,8 @@ void processModernCommand() {
     case 'A':  // Realtime data (modern protocol)
       {
         // Estrutura: [RC_OK] [offset_byte] [126 log entries]
-        uint8_t buffer[1 + 1 + LOG_ENTRIES_COUNT];
-        buffer[0] = SERIAL_RC_OK;
-        buffer[1] = 0x00;  // Offset byte (compatibilidade Speeduino)
-        buildRealtimePacket(&buffer[2]);  // 126 log entries começam no byte 2
-
-        uint16_t responseLength = 1 + 1 + LOG_ENTRIES_COUNT;  // RC_OK + offset + 126 entries = 128
-        sendU16BE(responseLength);
-        sendBytes(buffer, responseLength);
-        sendU32BE(calculateCRC32(buffer, responseLength));
+        // (RC_OK, length e CRC são acrescentados por txStream)
+        txStreamStart(TX_REALTIME, true, snapshotFront, 0, 1 + LOG_ENTRIES_COUNT);
       }
       break;
 
@@ -511,12 +784,20 @@ void processModernCommand() {
 
     case 'M':  // Write page
       {
-        uint8_t page = payload[2];
-        uint16_t offset = payload[3] | ((uint16_t)payload[4] << 8);
-        uint16_t length = payload[5] | ((uint16_t)payload[6] << 8);
-        uint8_t* data = &payload[7];
-
-        uint8_t result = writePageValues(page, offset, length, data);
+        // Formato: 'M' + CAN_ID + page + offset(2) + length(2) + dados
+        uint8_t result = SERIAL_RC_UKWN_ERR;
+        if (payloadLength >= PAGE_CMD_HEADER) {
+          uint8_t page = payload[2];
+          uint16_t offset = payload[3] | ((uint16_t)payload[4] << 8);
+          uint16_t length = payload[5] | ((uint16_t)payload[6] << 8);
+          // Frame grande: os dados estão na área de staging
+          const uint8_t* data = frameStreaming ? pageStaging : &payload[PAGE_CMD_HEADER];
+
+          // O length declarado não pode passar dos dados que chegaram
+          if (length <= payloadLength - PAGE_CMD_HEADER) {
+            result = writePageValues(page, offset, length, data);
+          }
+        }
 
         // Envia resposta
         sendU16BE(1);  // Length = 1
@@ -566,11 +847,53 @@ void processModernCommand() {
       }
       break;
 
+    case 'H':  // Liga tooth logger
+    case 'h':  // Desliga tooth logger
+    case 'J':  // Liga composite logger
+    case 'j':  // Desliga composite logger
+      {
+        if (command == 'H') {
+          toothLoggerStart(TOOTH_LOG_TOOTH);
+        } else if (command == 'J') {
+          toothLoggerStart(TOOTH_LOG_COMPOSITE);
+        } else {
+          toothLoggerStop();
+        }
+        uint8_t statusByte = SERIAL_RC_OK;
+        sendU16BE(1);
+        sendByte(statusByte);
+        sendU32BE(calculateCRC32(&statusByte, 1));
+      }
+      break;
+
+    case 'T':  // Lê tooth log / composite log
+      sendToothLog();
+      break;
+
+    case 'L':  // Datalog em push
+      {
+        // Formato: 'L' + taxa (Hz, 0 = desliga) + máscara de campos (uint32 LE)
+        //          [+ deltas entre keyframes (opcional, 0 = só keyframes)]
+        uint8_t result = SERIAL_RC_UKWN_ERR;
+        if (payloadLength >= 6) {
+          uint32_t mask = (uint32_t)payload[2] |
+                          ((uint32_t)payload[3] << 8) |
+                          ((uint32_t)payload[4] << 16) |
+                          ((uint32_t)payload[5] << 24);
+          uint8_t keyInterval = (payloadLength >= 7) ? payload[6] : 0;
+          result = datalogConfigure(payload[1], mask, keyInterval) ? SERIAL_RC_OK : SERIAL_RC_RANGE_ERR;
+        }
+        sendU16BE(1);
+        sendByte(result);
+        sendU32BE(calculateCRC32(&result, 1));
+      }
+      break;
+
     case 'b':  // Burn EEPROM
     case 'B':
       {
         burnEEPROM();
-        // Envia resposta
+        // Responde já: o burn segue na ISR EE_READY (burnPending no realtime)
         uint8_t statusByte = SERIAL_RC_BURN_OK;
         sendU16BE(1);
         sendByte(statusByte);
@@ -607,7 +930,10 @@ static bool readStructPageByte(const uint8_t* base, uint16_t size, uint16_t offs
 
 static PageWriteStatus writeStructPageByte(uint8_t* base, uint16_t size, uint16_t offset, uint8_t value) {
   if (offset >= size) return PAGE_WRITE_FAIL;
-  base[offset] = value;
+  if (base[offset] != value) {
+    base[offset] = value;
+    storageMarkDirty(&base[offset], 1);
+  }
   return PAGE_WRITE_OK;
 }
 
@@ -645,18 +971,28 @@ static PageWriteStatus writeVeTablePageByte(uint16_t offset, uint8_t value) {
   if (offset < SPEEDUINO_TABLE_CELLS) {
     uint8_t x = offset % SPEEDUINO_TABLE_DIM;
     uint8_t y = offset / SPEEDUINO_TABLE_DIM;
-    veTable.values[y][x] = value;
+    if (veTable.values[y][x] != value) {
+      veTable.values[y][x] = value;
+      storageMarkDirty(&veTable.values[y][x], 1);
+    }
     return PAGE_WRITE_TABLE_CHANGED;
   }
 
   if (offset < SPEEDUINO_TABLE_CELLS + SPEEDUINO_TABLE_AXIS_LEN) {
     uint8_t idx = offset - SPEEDUINO_TABLE_CELLS;
-    veTable.axisX[idx] = decodeRpmBin(value);
+    uint16_t rpm = decodeRpmBin(value);
+    if (veTable.axisX[idx] != rpm) {
+      veTable.axisX[idx] = rpm;
+      storageMarkDirty(&veTable.axisX[idx], sizeof(uint16_t));
+    }
     return PAGE_WRITE_TABLE_CHANGED;
   }
 
   uint8_t idx = offset - (SPEEDUINO_TABLE_CELLS + SPEEDUINO_TABLE_AXIS_LEN);
-  veTable.axisY[idx] = value;
+  if (veTable.axisY[idx] != value) {
+    veTable.axisY[idx] = value;
+    storageMarkDirty(&veTable.axisY[idx], 1);
+  }
   return PAGE_WRITE_TABLE_CHANGED;
 }
 
@@ -687,18 +1023,29 @@ static PageWriteStatus writeIgnTablePageByte(uint16_t offset, uint8_t value) {
   if (offset < SPEEDUINO_TABLE_CELLS) {
     uint8_t x = offset % SPEEDUINO_TABLE_DIM;
     uint8_t y = offset / SPEEDUINO_TABLE_DIM;
-    ignTable.valuesI[y][x] = decodeIgnitionValue(value);
+    int8_t advance = decodeIgnitionValue(value);
+    if (ignTable.valuesI[y][x] != advance) {
+      ignTable.valuesI[y][x] = advance;
+      storageMarkDirty(&ignTable.valuesI[y][x], 1);
+    }
     return PAGE_WRITE_TABLE_CHANGED;
   }
 
   if (offset < SPEEDUINO_TABLE_CELLS + SPEEDUINO_TABLE_AXIS_LEN) {
     uint8_t idx = offset - SPEEDUINO_TABLE_CELLS;
-    ignTable.axisX[idx] = decodeRpmBin(value);
+    uint16_t rpm = decodeRpmBin(value);
+    if (ignTable.axisX[idx] != rpm) {
+      ignTable.axisX[idx] = rpm;
+      storageMarkDirty(&ignTable.axisX[idx], sizeof(uint16_t));
+    }
     return PAGE_WRITE_TABLE_CHANGED;
   }
 
   uint8_t idx = offset - (SPEEDUINO_TABLE_CELLS + SPEEDUINO_TABLE_AXIS_LEN);
-  ignTable.axisY[idx] = value;
+  if (ignTable.axisY[idx] != value) {
+    ignTable.axisY[idx] = value;
+    storageMarkDirty(&ignTable.axisY[idx], 1);
+  }
   return PAGE_WRITE_TABLE_CHANGED;
 }
 
@@ -751,42 +1098,9 @@ void sendPageValues(uint8_t page, uint16_t offset, uint16_t length) {
 
   uint16_t available = (offset < pageSz) ? (pageSz - offset) : 0;
   uint16_t actualLength = (length < available) ? length : available;
-  uint16_t responseLength = 1 + actualLength;
-
-  sendU16BE(responseLength);
-
-  uint8_t tempBuf[32];
-  uint32_t crc = 0xFFFFFFFF;
-
-  // Status byte
-  sendByte(SERIAL_RC_OK);
-  crc = crc32Update(crc, SERIAL_RC_OK);
-
-  uint16_t remaining = actualLength;
-  uint16_t pos = 0;
-
-  while (remaining > 0) {
-    uint16_t blockSize = (remaining < sizeof(tempBuf)) ? remaining : sizeof(tempBuf);
-    for (uint16_t i = 0; i < blockSize; i++) {
-      uint8_t byteValue = 0;
-      if (!readPageByte(page, offset + pos + i, byteValue)) {
-        byteValue = 0;
-      }
-      tempBuf[i] = byteValue;
-    }
-
-    sendBytes(tempBuf, blockSize);
-
-    for (uint16_t i = 0; i < blockSize; i++) {
-      crc = crc32Update(crc, tempBuf[i]);
-    }
-
-    pos += blockSize;
-    remaining -= blockSize;
-  }
-
-  crc = ~crc;
-  sendU32BE(crc);
+  // [length] [RC_OK] [dados] [CRC]: os bytes são lidos da página conforme
+  // o buffer de TX libera espaço
+  txStreamStart(TX_PAGE, true, page, offset, actualLength);
 }
 
 uint8_t writePageValues(uint8_t page, uint16_t offset, uint16_t length, const uint8_t* data) {
@@ -796,6 +1110,9 @@ uint8_t writePageValues(uint8_t page, uint16_t offset, uint16_t length, const ui
     return SERIAL_RC_RANGE_ERR;
   }
 
+  // Antes do loop: uma falha no meio já pode ter alterado parte da página
+  pageCRCValid &= ~(1U << page);
+
   bool tableChanged = false;
   for (uint16_t i = 0; i < length; i++) {
     PageWriteStatus status = writePageByte(page, offset + i, data[i]);
@@ -811,6 +1128,16 @@ uint8_t writePageValues(uint8_t page, uint16_t offset, uint16_t length, const ui
     clearTableCaches();
   }
 
+  // Tabela WUE mora na página 1: o produto das correções está em cache
+  if (page == 1) {
+    fuelApplyConfig();
+  }
+
+  // Polaridade das bobinas (ignInvert) mora na página 4
+  if (page == 4) {
+    schedulerApplyConfig();
+  }
+
   return SERIAL_RC_OK;
 }
 
@@ -825,16 +1152,21 @@ void sendPageCRC32(uint8_t page) {
     return;
   }
 
-  uint32_t crc = 0xFFFFFFFF;
-  for (uint16_t i = 0; i < pageSz; i++) {
-    uint8_t byteValue = 0;
-    if (!readPageByte(page, i, byteValue)) {
-      byteValue = 0;
+  uint32_t pageCRC = pageCRCCache[page];
+  if (!(pageCRCValid & (1U << page))) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint16_t i = 0; i < pageSz; i++) {
+      uint8_t byteValue = 0;
+      if (!readPageByte(page, i, byteValue)) {
+        byteValue = 0;
+      }
+      crc = crc32Update(crc, byteValue);
     }
-    crc = crc32Update(crc, byteValue);
-  }
 
-  uint32_t pageCRC = ~crc;
+    pageCRC = ~crc;
+    pageCRCCache[page] = pageCRC;
+    pageCRCValid |= (1U << page);
+  }
 
   uint32_t reversedCRC = ((pageCRC & 0xFF) << 24) |
                          ((pageCRC & 0xFF00) << 8) |
@@ -865,13 +1197,9 @@ void sendOutputChannels(uint8_t subcmd, uint16_t offset, uint16_t length) {
     //   data[15] = getTSLogEntry(14) = RPM low
     //   data[16] = getTSLogEntry(15) = RPM high
 
-    uint8_t fullBuffer[1 + LOG_ENTRIES_COUNT];  // offset byte + 126 log entries
-    fullBuffer[0] = 0x00;  // Offset byte (compatibilidade Speeduino)
-    buildRealtimePacket(&fullBuffer[1]);  // 126 log entries começam no índice 1
-
     // Ajusta offset e length para incluir o offset byte
     // TunerStudio pede offset=0, length=127
-    // Devemos retornar: [RC_OK] + fullBuffer[0:127]
+    // Devemos retornar: [RC_OK] + [offset byte + 126 log entries][offset:length]
     uint16_t fullBufferSize = 1 + LOG_ENTRIES_COUNT;  // 127 bytes total
     if (offset >= fullBufferSize) {
       offset = 0;
@@ -881,32 +1209,9 @@ void sendOutputChannels(uint8_t subcmd, uint16_t offset, uint16_t length) {
       length = fullBufferSize - offset;
     }
 
-    // Monta resposta: [length] [RC_OK] [dados] [CRC]
-    uint16_t responseLength = 1 + length;  // RC_OK + dados
-    sendU16BE(responseLength);
-
-    // Envia RC_OK
-    sendByte(SERIAL_RC_OK);
-
-    // Envia dados (offset byte + log entries)
-    sendBytes(fullBuffer + offset, length);
-
-    // Calcula CRC (RC_OK + dados)
-    uint32_t crc = 0xFFFFFFFF;
-
-    // Passo 1: CRC do status byte
-    uint8_t statusByte = SERIAL_RC_OK;
-    uint8_t index = (crc ^ statusByte) & 0xFF;
-    crc = (crc >> 8) ^ pgm_read_dword(&crc32_table[index]);
-
-    // Passo 2: CRC dos dados
-    for (uint16_t i = 0; i < length; i++) {
-      index = (crc ^ fullBuffer[offset + i]) & 0xFF;
-      crc = (crc >> 8) ^ pgm_read_dword(&crc32_table[index]);
-    }
-
-    crc = ~crc;
-    sendU32BE(crc);
+    // Resposta: [length] [RC_OK] [dados] [CRC], entregue por txStream
+    // direto do snapshot publicado
+    txStreamStart(TX_REALTIME, true, snapshotFront, offset, length);
   } else {
     // Subcomando desconhecido
     uint8_t err = SERIAL_RC_UKWN_ERR;
@@ -917,121 +1222,221 @@ void sendOutputChannels(uint8_t subcmd, uint16_t offset, uint16_t length) {
 }
 
 void burnEEPROM() {
-  saveAllConfig();
+  storageBurnStart();
 }
 
 // ============================================================================
-// REALTIME DATA PACKET (126 bytes de log entries)
+// DATALOG EM PUSH
 // ============================================================================
-//
-// Speeduino usa getTSLogEntry(n) onde n = 0..125 (126 entries)
-// Não inclui o offset byte 0x00 - isso é adicionado pela camada de protocolo
-//
-void buildRealtimePacket(uint8_t* buffer) {
-  // Zera buffer (126 bytes)
-  memset(buffer, 0, LOG_ENTRIES_COUNT);
-
-  // Offset 0: secl
-  buffer[0] = currentStatus.secl & 0xFF;
-
-  // Offset 1: status1
-  buffer[1] = 0;
-  if (currentStatus.RPM > 0) buffer[1] |= 0x01;  // Engine running
-
-  // Offset 2: engine
-  buffer[2] = currentStatus.engineStatus;
+// O realtime por pedido custa um round trip com CRC por amostra; aqui o ECU
+// manda sozinho, na taxa pedida, só os campos escolhidos. Pensado para o
+// tools/datalog (o TunerStudio não espera frames que não pediu).
+
+// Envia um byte do frame e acumula no CRC
+static inline uint32_t sendByteCRC(uint32_t crc, uint8_t value) {
+  sendByte(value);
+  return crc32Update(crc, value);
+}
 
-  // Offset 3: syncLoss (sempre 0 se tiver sync)
-  buffer[3] = currentStatus.hasSync ? 0 : 1;
+static bool datalogConfigure(uint8_t rate, uint32_t mask, uint8_t keyInterval) {
+  if (rate > DATALOG_MAX_RATE) {
+    return false;
+  }
 
-  // Offset 4-5: MAP (uint16, little-endian)
-  uint16_t map16 = currentStatus.MAP * 10;  // kPa * 10
-  buffer[4] = map16 & 0xFF;
-  buffer[5] = (map16 >> 8) & 0xFF;
+  // Bits além do último campo são ignorados; máscara vazia = todos
+  mask &= OUTPUT_FIELDS_ALL;
+  if (mask == 0) {
+    mask = OUTPUT_FIELDS_ALL;
+  }
 
-  // Offset 6: IAT (temperatura + 40)
-  buffer[6] = currentStatus.IAT + 40;
+  uint8_t length = 0;
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < OUTPUT_FIELD_COUNT; i++) {
+    if (mask & (1UL << i)) {
+      length += pgm_read_byte(&outputFieldSize[i]);
+      count++;
+    }
+  }
 
-  // Offset 7: coolant (temperatura + 40)
-  buffer[7] = currentStatus.coolant + 40;
+  datalogRate = rate;
+  datalogPeriod = (rate > 0) ? (1000 / rate) : 0;
+  datalogMask = mask;
+  datalogFields = count;
+  datalogLength = length;
+  datalogSeq = 0;
+  datalogKeyInterval = keyInterval;
+  datalogSinceKey = keyInterval;  // Primeiro frame é sempre keyframe
+  lastDatalog = (uint16_t)millis();
+  return true;
+}
 
-  // Offset 8: batCorrection
-  buffer[8] = currentStatus.batCorrection;
+void commsDatalogProcess() {
+  if (datalogRate == 0) {
+    return;
+  }
 
-  // Offset 9: battery10
-  buffer[9] = currentStatus.battery10;
+  uint16_t now = (uint16_t)millis();
+  if ((uint16_t)(now - lastDatalog) < datalogPeriod) {
+    return;
+  }
+  lastDatalog = now;
+  uint8_t seq = datalogSeq++;
+
+  const uint8_t* snapshot = (const uint8_t*)&outputSnapshot[snapshotFront];
+
+  // Delta: campos escolhidos que mudaram desde o último frame enviado
+  // (bit k = k-ésimo campo escolhido). A maior parte dos canais muda pouco,
+  // o que multiplica a taxa útil em links lentos (Bluetooth a 9600-38400).
+  bool keyframe = (datalogSinceKey >= datalogKeyInterval);
+  uint32_t changed = 0;
+  uint8_t changedLength = 0;
+  if (!keyframe) {
+    uint8_t position = 0;
+    uint8_t k = 0;
+    for (uint8_t i = 0; i < OUTPUT_FIELD_COUNT; i++) {
+      uint8_t size = pgm_read_byte(&outputFieldSize[i]);
+      if (datalogMask & (1UL << i)) {
+        if (memcmp(&snapshot[position], &datalogLast[position], size) != 0) {
+          changed |= 1UL << k;
+          changedLength += size;
+        }
+        k++;
+      }
+      position += size;
+    }
+  }
+  uint8_t bitmapBytes = (datalogFields + 7) / 8;
 
-  // Offset 10: O2
-  buffer[10] = currentStatus.O2;
+  uint8_t payloadLength = keyframe ? (1 + DATALOG_HEADER + datalogLength)
+                                   : (1 + DATALOG_DELTA_HEADER + bitmapBytes + changedLength);
 
-  // Offset 11: egoCorrection
-  buffer[11] = 100;  // Sem correção O2 ainda
+  // Resposta saindo ou buffer de TX sem espaço para o frame inteiro:
+  // descarta a amostra em vez de bloquear o loop (o salto no seq mostra; o
+  // próximo delta continua valendo contra o último frame enviado)
+  if (txStream.source != TX_IDLE || Serial.availableForWrite() < (2 + payloadLength + 4)) {
+    return;
+  }
 
-  // Offset 12: iatCorrection
-  buffer[12] = 100;
+  sendU16BE(payloadLength);
+  uint32_t crc = sendByteCRC(0xFFFFFFFF, keyframe ? SERIAL_RC_DATALOG : SERIAL_RC_DATALOG_DELTA);
+  crc = sendByteCRC(crc, seq);
+  if (!keyframe) {
+    crc = sendByteCRC(crc, datalogLastSeq);
+  }
+  crc = sendByteCRC(crc, now & 0xFF);
+  crc = sendByteCRC(crc, now >> 8);
+  if (keyframe) {
+    for (uint8_t shift = 0; shift < 32; shift += 8) {
+      crc = sendByteCRC(crc, (uint8_t)(datalogMask >> shift));
+    }
+  } else {
+    for (uint8_t b = 0; b < bitmapBytes; b++) {
+      crc = sendByteCRC(crc, (uint8_t)(changed >> (8 * b)));
+    }
+  }
 
-  // Offset 13: wueCorrection
-  buffer[13] = currentStatus.wueCorrection;
+  // Campos (todos os escolhidos no keyframe, só os alterados no delta),
+  // direto do snapshot publicado
+  uint8_t position = 0;
+  uint8_t k = 0;
+  for (uint8_t i = 0; i < OUTPUT_FIELD_COUNT; i++) {
+    uint8_t size = pgm_read_byte(&outputFieldSize[i]);
+    if (datalogMask & (1UL << i)) {
+      if (keyframe || (changed & (1UL << k))) {
+        for (uint8_t b = 0; b < size; b++) {
+          crc = sendByteCRC(crc, snapshot[position + b]);
+        }
+      }
+      k++;
+    }
+    position += size;
+  }
 
-  // Offset 14-15: RPM (uint16, little-endian)
-  buffer[14] = currentStatus.RPM & 0xFF;
-  buffer[15] = (currentStatus.RPM >> 8) & 0xFF;
+  sendU32BE(~crc);
 
-  // Offset 24: advance
-  buffer[24] = (currentStatus.advance + 40);  // Offset para permitir negativos
+  memcpy(datalogLast, snapshot, sizeof(datalogLast));
+  datalogLastSeq = seq;
+  datalogSinceKey = keyframe ? 0 : (datalogSinceKey + 1);
+}
 
-  // Offset 25: TPS
-  buffer[25] = currentStatus.TPS;
+// ============================================================================
+// TOOTH LOGGER / COMPOSITE LOGGER
+// ============================================================================
 
-  // Offset 26-27: loopsPerSec (uint16)
-  uint16_t loops = 2000;
-  buffer[26] = loops & 0xFF;
-  buffer[27] = (loops >> 8) & 0xFF;
+void sendToothLog() {
+  if (!toothLogReady()) {
+    uint8_t err = SERIAL_RC_BUSY_ERR;
+    sendU16BE(1);
+    sendByte(err);
+    sendU32BE(calculateCRC32(&err, 1));
+    return;
+  }
 
-  // Offset 28-29: freeRAM
-  extern int __heap_start, *__brkval;
-  int v;
-  uint16_t freeRam = (int)&v - (__brkval == 0 ? (int)&__heap_start : (int)__brkval);
-  buffer[28] = freeRam & 0xFF;
-  buffer[29] = (freeRam >> 8) & 0xFF;
+  // Registros gerados conforme o buffer de TX libera espaço; a captura
+  // recomeça quando o último byte sai (commsTransmit)
+  uint8_t recordSize = (toothLogMode == TOOTH_LOG_COMPOSITE) ? 5 : 4;
+  txStreamStart(TX_TOOTHLOG, true, 0, 0, (uint16_t)TOOTH_LOG_SIZE * recordSize);
+}
 
-  // Offset 32: spark (bitfield)
-  buffer[32] = currentStatus.hasSync ? 0x01 : 0x00;
+// ============================================================================
+// REALTIME DATA PACKET (126 bytes de log entries)
+// ============================================================================
+//
+// Speeduino usa getTSLogEntry(n) onde n = 0..125 (126 entries)
+// Não inclui o offset byte 0x00 - isso é adicionado pela camada de protocolo
+//
+void commsUpdateSnapshot() {
+  uint8_t back = snapshotFront ^ 1;
 
-  // Offset 35: ethanolPct
-  buffer[35] = 0;  // Sem flex fuel
+  // O buffer de trás ainda está saindo pela serial (foi publicado antes da
+  // última troca): pula esta atualização para não rasgar a resposta
+  if (txStream.source == TX_REALTIME && txStream.page == back) {
+    return;
+  }
 
-  // Offset 38: idleLoad (duty da válvula de marcha lenta, %)
-  buffer[38] = currentStatus.idleValveDuty;
+  OutputChannels& out = outputSnapshot[back];
 
-  // Offset 41: baro
-  buffer[41] = 100;  // 100 kPa (atmosférico)
+  out.secl = currentStatus.secl & 0xFF;
 
-  // Offset 76-77: PW1 (microsegundos, uint16, little-endian)
-  buffer[76] = currentStatus.PW1 & 0xFF;
-  buffer[77] = (currentStatus.PW1 >> 8) & 0xFF;
+  out.status1 = 0;
+  if (currentStatus.RPM > 0) out.status1 |= 0x01;  // Engine running
+  if (toothLogReady()) out.status1 |= 0x40;         // toothLog1Ready (tooth/composite logger)
+  if (storageBurnBusy()) out.status1 |= 0x80;       // burnPending (EEPROM gravando em segundo plano)
 
-  // Offset 78-79: PW2 (little-endian)
-  buffer[78] = currentStatus.PW2 & 0xFF;
-  buffer[79] = (currentStatus.PW2 >> 8) & 0xFF;
+  out.engine = currentStatus.engineStatus;
+  out.syncLoss = currentStatus.hasSync ? 0 : 1;
+  out.MAP = currentStatus.MAPx10;  // kPa * 10
+  out.IAT = currentStatus.IAT + 40;
+  out.coolant = currentStatus.coolant + 40;
+  out.batCorrection = currentStatus.batCorrection;
+  out.battery10 = currentStatus.battery10;
+  out.O2 = currentStatus.O2;
+  out.egoCorrection = 100;
+  out.iatCorrection = 100;
+  out.wueCorrection = currentStatus.wueCorrection;
+  out.RPM = currentStatus.RPM;
 
-  // Offset 80-81: PW3 (little-endian)
-  buffer[80] = currentStatus.PW3 & 0xFF;
-  buffer[81] = (currentStatus.PW3 >> 8) & 0xFF;
+  out.advance = currentStatus.advance + 40;
+  out.TPS = currentStatus.TPSx2;  // 0,5%
+  out.loopsPerSec = 2000;
 
-  // Offset 82-83: PW4 (0 - não temos 4º canal)
-  buffer[82] = 0;
-  buffer[83] = 0;
+  extern int __heap_start, *__brkval;
+  int v;
+  out.freeRAM = (int)&v - (__brkval == 0 ? (int)&__heap_start : (int)__brkval);
 
-  // Offset 92: CLIdleTarget (alvo de marcha lenta, RPM / 10 - escala Speeduino)
-  buffer[92] = (uint8_t)(currentStatus.CLIdleTarget / 10U);
+  out.spark = currentStatus.hasSync ? 0x01 : 0x00;
+  out.idleLoad = currentStatus.idleValveDuty;
+  out.baro = 100;
 
-  // Offset 102: VE
-  buffer[102] = currentStatus.VE;
+  // PW1/PW2 são publicados pelo loop com interrupções desligadas; aqui é o
+  // mesmo contexto, então a cópia já sai consistente
+  out.PW1 = currentStatus.PW1;
+  out.PW2 = currentStatus.PW2;
+  out.PW3 = currentStatus.PW3;
 
-  // Offset 104-105: VSS (km/h, uint16)
-  buffer[104] = 0;
-  buffer[105] = 0;
+  out.CLIdleTarget = (uint8_t)(currentStatus.CLIdleTarget / 10U);
+  out.VE = currentStatus.VE;
 
-  // Resto: zeros (já foi feito com memset)
+  // Publica: troca de 1 byte, atômica
+  snapshotFront = back;
 }
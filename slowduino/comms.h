@@ -21,6 +21,9 @@
 #define SERIAL_RC_RANGE_ERR 0x80  // Erro de range/offset
 #define SERIAL_RC_CRC_ERR   0x82  // Erro de CRC
 #define SERIAL_RC_UKWN_ERR  0x83  // Comando desconhecido
+#define SERIAL_RC_BUSY_ERR  0x85  // Dado ainda não disponível (tooth log incompleto)
+#define SERIAL_RC_DATALOG   0x10  // Frame de datalog em push (não é resposta a comando)
+#define SERIAL_RC_DATALOG_DELTA 0x11  // Datalog em push: só os campos que mudaram
 
 // ============================================================================
 // TAMANHOS
@@ -28,13 +31,17 @@
 #define LOG_ENTRY_SIZE      127   // Tamanho TOTAL do pacote (offset byte + 126 log entries)
 #define LOG_ENTRIES_COUNT   126   // Quantidade de log entries (getTSLogEntry)
 #define SERIAL_BUFFER_SIZE  64    // Buffer de recepção
+#define PAGE_STAGING_SIZE   144   // Dados de um 'M' grande (metade de uma tabela 16x16+eixos)
 #define PAGE_COUNT          16    // Speeduino usa páginas 0-15
 
 // ============================================================================
 // SERIAL CAPABILITY (compatibilidade Speeduino)
 // ============================================================================
-#define BLOCKING_FACTOR       121   // Para AVR (ATmega328p)
-#define TABLE_BLOCKING_FACTOR 64    // Para AVR
+// Maior bloco que o TunerStudio manda num 'M'. Frames maiores que o
+// serialBuffer são recebidos em streaming para a área de staging, então o
+// limite é PAGE_STAGING_SIZE: uma página de 288 bytes sobe em 2 frames.
+#define BLOCKING_FACTOR       PAGE_STAGING_SIZE
+#define TABLE_BLOCKING_FACTOR PAGE_STAGING_SIZE
 
 // ============================================================================
 // ESTRUTURA DE PÁGINAS
@@ -188,7 +195,8 @@ uint8_t writePageValues(uint8_t page, uint16_t offset, uint16_t length, const ui
 /**
  * @brief Envia CRC32 de uma página
  *
- * Comando 'd'
+ * Comando 'd'. Calculado uma vez e guardado até writePageValues() alterar
+ * a página.
  * @param page Número da página
  */
 void sendPageCRC32(uint8_t page);
@@ -203,10 +211,20 @@ void sendPageCRC32(uint8_t page);
  */
 void sendOutputChannels(uint8_t subcmd, uint16_t offset, uint16_t length);
 
+/**
+ * @brief Envia o buffer do tooth logger / composite logger
+ *
+ * Comando 'T'. Tooth log: 4 bytes por entrada (intervalo em us). Composite:
+ * 5 bytes (tempo acumulado em us + status). Big-endian, como o Speeduino.
+ * Responde SERIAL_RC_BUSY_ERR se a captura ainda não encheu o buffer.
+ */
+void sendToothLog();
+
 /**
  * @brief Burn EEPROM
  *
- * Comando 'b' ou 'B'
+ * Comando 'b' ou 'B'. Só dispara o burn em segundo plano (storageBurnStart)
+ * e retorna; o fim aparece no bit burnPending do status1 do realtime.
  */
 void burnEEPROM();
 
@@ -225,13 +243,23 @@ uint8_t* getPagePointer(uint8_t page);
 uint16_t getPageSize(uint8_t page);
 
 /**
- * @brief Monta pacote de realtime data (126 bytes de log entries)
+ * @brief Envia um frame de datalog em push, se for a hora
  *
- * Preenche buffer com dados do currentStatus.
- * NÃO inclui o offset byte inicial (0x00) - isso é adicionado pela camada de protocolo.
+ * Ativado pelo comando 'L' (taxa em Hz + máscara de campos + intervalo de
+ * keyframes opcional; entre keyframes vão só os campos alterados). Chamar
+ * do loop principal logo após commsUpdateSnapshot(). Nunca bloqueia: se houver
+ * resposta saindo ou o buffer de TX não comportar o frame inteiro, a
+ * amostra é descartada (o número de sequência avança mesmo assim).
+ */
+void commsDatalogProcess();
+
+/**
+ * @brief Atualiza o snapshot do realtime (log entries Speeduino)
  *
- * @param buffer Buffer de saída (mínimo 126 bytes)
+ * Codifica currentStatus num buffer duplo e publica de uma vez; 'A' e 'r'
+ * enviam direto do snapshot publicado, sem remontar o pacote a cada pedido.
+ * Chamar do loop principal (não de ISR).
  */
-void buildRealtimePacket(uint8_t* buffer);
+void commsUpdateSnapshot();
 
 #endif // COMMS_H
@@ -21,15 +21,13 @@
 // ============================================================================
 
 // Timer1 - 16 bits, usado para scheduler de injeção e ignição
-// Prescaler 256: 16MHz / 256 = 62.5kHz -> 16µs por tick
-// Máximo: 65536 * 16µs = 1.048s (cobre cranking lento sem overflow)
-#define TIMER1_PRESCALER    256
-#define TIMER1_RESOLUTION   16.0  // microsegundos por tick (não usado diretamente, apenas doc)
+// Prescaler 256: 16MHz / 256 = 62.5kHz -> 16µs por tick (baixa rotação)
+// Prescaler 8:   16MHz / 8   = 2MHz    -> 0.5µs por tick (alta rotação)
+// A escala ativa e as conversões US_TO_TIMER1/TIMER1_TO_US ficam em scheduler.h
 
-// Conversão de microsegundos para ticks do Timer1
-#define US_TO_TIMER1(us)    ((uint16_t)((us) / 16))
-
-#define TIMER1_TO_US(ticks) ((uint32_t)(ticks) * 16U)
+// Faixas de troca do prescaler (histerese), por tempo de revolução
+#define TIMER1_FINE_ENTER_US  20000  // < 20ms (> 3000 RPM) -> prescaler 8
+#define TIMER1_FINE_EXIT_US   24000  // > 24ms (< 2500 RPM) -> volta ao 256
 
 // ============================================================================
 // CONSTANTES DE SENSORES
@@ -46,6 +44,25 @@
 #define FILTER_OIL_PRESS   100   // Pressão óleo: média
 #define FILTER_FUEL_PRESS  100   // Pressão combustível: média
 
+// Amostrador do ADC (ADC_vect) - valores em log2
+// ADC_RATE_*: o canal é convertido a cada 2^n voltas do round-robin
+// (0 = toda volta). ADC_OVERSAMPLE_*: soma de 2^n conversões por resultado
+// (máx 6 - a soma de 64 leituras de 10 bits ainda cabe num uint16_t).
+// ADC_EXTRA_BITS_*: bits ganhos na decimação - o resultado é a soma >>
+// (oversample - extra). Cada bit extra custa 4x conversões (oversample >=
+// 2 * extra) e depende do ruído do sinal (>= 1 LSB) para valer.
+// Cada conversão leva ~104us (prescaler 128 -> 125kHz, 13 ciclos de ADC).
+#define ADC_RATE_MAP             0
+#define ADC_RATE_TPS             0
+#define ADC_RATE_O2              1
+#define ADC_RATE_SLOW            3   // CLT, IAT, bateria, pressões
+#define ADC_OVERSAMPLE_MAP       4   // 16 conversões -> 12 bits
+#define ADC_OVERSAMPLE_TPS       4
+#define ADC_OVERSAMPLE_O2        1
+#define ADC_OVERSAMPLE_SLOW      2
+#define ADC_EXTRA_BITS_MAP       2   // mapADC/tpsADC em 12 bits (0-4095)
+#define ADC_EXTRA_BITS_TPS       2
+
 // Limites de ADC (10-bit: 0-1023)
 #define ADC_MIN             0
 #define ADC_MAX          1023
@@ -53,6 +70,13 @@
 // Referência ADC (mV)
 #define ADC_VREF         5000    // 5V
 
+// Curvas de calibração (configPage1.cltCalibration/iatCalibration e
+// configPage2.o2Calibration): um ponto a cada 2^CALIBRATION_SHIFT contagens
+// do ADC de 10 bits, de 0 a 1024 (o último ponto vale para o ADC 1023)
+#define CALIBRATION_SHIFT        5
+#define CALIBRATION_POINTS      ((1024 >> CALIBRATION_SHIFT) + 1)   // 33
+#define CALIBRATION_TEMP_OFFSET 40    // Temperatura guardada como °C + 40
+
 // Divisor de tensão da bateria (R1=10K, R2=1K5 -> 14.5V = ~1.87V no ADC)
 // Bateria = (ADC * VREF / 1024) * (R1+R2) / R2
 // Com R1=10K, R2=1K5: multiplicador = 7.67
@@ -70,6 +94,10 @@
 // Timeout para perda de sincronismo (ms)
 #define SYNC_TIMEOUT       1000   // 1 segundo sem dente = perda de sync
 
+// Tooth logger / composite logger: entradas capturadas por leitura do
+// TunerStudio (3 bytes de RAM cada)
+#define TOOTH_LOG_SIZE       32
+
 // ============================================================================
 // CONSTANTES DE INJEÇÃO
 // ============================================================================
@@ -79,7 +107,11 @@
 #define INJ_MAX_PW        20000   // 20ms máximo
 
 // Ângulo de injeção padrão (graus BTDC)
-#define INJ_ANGLE_DEFAULT   355   // 5 graus BTDC
+// Fim da injeção sequencial (graus antes do PMS de compressão do cilindro).
+// O PMS de admissão fica a 360°; a válvula de admissão abre tipicamente 10-30°
+// antes dele. 400 termina o pulso 40° antes do PMS de admissão, ainda com a
+// válvula fechada (fim do escape).
+#define INJ_ANGLE_DEFAULT   400
 
 // ============================================================================
 // CONSTANTES DE IGNIÇÃO
@@ -147,6 +179,9 @@
 // Buffer de comunicação
 #define SERIAL_BUFFER_SIZE   64   // Bytes
 
+// Datalog em push (comando 'L'): maior taxa aceita, em frames por segundo
+#define DATALOG_MAX_RATE    100
+
 // Comandos do protocolo TunerStudio simplificado
 #define CMD_READ_REALTIME   'A'   // Lê dados em tempo real
 #define CMD_READ_VE         'V'   // Lê tabela VE
@@ -181,13 +216,28 @@
 #define EEPROM_CONFIG1        (EEPROM_IGN_AXIS_Y + 16) // 128 bytes - fuel config
 #define EEPROM_CONFIG2        (EEPROM_CONFIG1 + 128)   // 128 bytes - ignition config
 
-// Área auxiliar para AFR target (usa espaço antes reservado para CLT/IAT)
-#define EEPROM_AFR_STORAGE    (EEPROM_CONFIG2 + 128)   // 120 bytes usados para AFR
-#define EEPROM_AFR_STORAGE_LEN 120
-
-// Reserva para expansão futura (restante da EEPROM)
-#define EEPROM_SPARE          (EEPROM_AFR_STORAGE + EEPROM_AFR_STORAGE_LEN)
-#if EEPROM_SPARE > 1024
+// Burn em segundo plano: passos (bytes comparados/blocos pulados) por
+// interrupção EE_READY antes de devolver a CPU quando nada mudou
+#define EEPROM_BURN_SCAN_BYTES  8
+
+// Granularidade do controle de alterações: blocos de 16 bytes da EEPROM
+// (64 blocos, bitmap de 8 bytes)
+#define EEPROM_DIRTY_BLOCK_SHIFT  4
+#define EEPROM_DIRTY_BLOCKS       (1024 >> EEPROM_DIRTY_BLOCK_SHIFT)
+
+// Journal do burn (antes área reservada para AFR, nunca usada). Começa num
+// limite de bloco: 2 registros A/B (seq, primeiro slot, nº de blocos, CRC16)
+// e um anel de slots de bloco (índice + 16 bytes)
+#define EEPROM_JOURNAL          880
+#define EEPROM_JOURNAL_RECORD   5
+#define EEPROM_JOURNAL_ENTRIES  (EEPROM_JOURNAL + 2 * EEPROM_JOURNAL_RECORD)
+#define EEPROM_JOURNAL_ENTRY    (1 + (1 << EEPROM_DIRTY_BLOCK_SHIFT))
+#define EEPROM_JOURNAL_SLOTS    7   // Blocos por transação atômica
+
+#if (EEPROM_CONFIG2 + 128) > EEPROM_JOURNAL
+#error "Imagem da EEPROM invade o journal"
+#endif
+#if (EEPROM_JOURNAL_ENTRIES + EEPROM_JOURNAL_SLOTS * EEPROM_JOURNAL_ENTRY) > 1024
 #error "Layout EEPROM ultrapassa 1024 bytes"
 #endif
 
@@ -211,6 +261,7 @@ extern volatile uint8_t loopTimerFlags;
 // Injector layout
 #define INJ_LAYOUT_PAIRED         0   // Wasted paired (2 canais)
 #define INJ_LAYOUT_SEMI_SEQ       1   // Semi-sequential (4 canais - futuro)
+#define INJ_LAYOUT_SEQUENTIAL     3   // Sequencial (exige sensor de fase)
 
 // AE mode
 #define AE_MODE_TPS               0   // Baseado em TPSdot
@@ -225,9 +276,15 @@ extern volatile uint8_t loopTimerFlags;
 #define TRIGGER_EDGE_FALLING      1
 #define TRIGGER_EDGE_BOTH         2
 
-// MAP sampling
-#define MAP_SAMPLE_INSTANT        0   // Leitura instantânea
+// Sensor de fase no comando (configPage2.camInput)
+#define CAM_INPUT_OFF             0   // Sem sensor: ciclo de 360°, fase desconhecida
+#define CAM_INPUT_SINGLE          1   // 1 pulso por ciclo de 720°
+
+// Amostragem do MAP (configPage1.mapSample)
+#define MAP_SAMPLE_INSTANT        0   // Último resultado do ADC, a cada MAP_INSTANT_INTERVAL
 #define MAP_SAMPLE_AVERAGE        1   // Média do ciclo
+#define MAP_SAMPLE_MINIMUM        2   // Mínimo do ciclo
+#define MAP_INSTANT_INTERVAL     33   // ms entre leituras no modo instantâneo
 
 // ============================================================================
 // CONSTANTES DE AUXILIARES
@@ -7,6 +7,7 @@
 #include "scheduler.h"
 #include "fuel.h"
 #include "ignition.h"
+#include "sensors.h"
 
 // Forward declarations
 void scheduleInjection();
@@ -23,7 +24,28 @@ typedef void (*TriggerISR)(void);
 volatile TriggerISR currentTriggerISR = nullptr;
 
 // Controle de sequenciamento
-volatile uint8_t revolutionCounter = 0;  // 0 ou 1 (para alternar cilindros)
+// Volta do ciclo de 720° (0 ou 1). Só corresponde à fase real do motor com
+// triggerState.hasCycleSync; sem sensor de fase apenas alterna os canais.
+volatile uint8_t revolutionCounter = 0;
+
+volatile bool triggerNewCycle = false;
+
+#if defined(TRIGGER_USE_ICP1)
+// Instante da borda atual, travado pelo hardware no ICR1 (ISR de captura)
+static volatile uint32_t triggerCaptureTime = 0;
+
+// Ambas as bordas: ICES1 é invertido a cada captura
+static bool triggerCaptureBothEdges = true;
+#endif
+
+// Timestamp da borda sendo processada pela ISR do decoder
+static inline uint32_t triggerEdgeTime() {
+#if defined(TRIGGER_USE_ICP1)
+  return triggerCaptureTime;
+#else
+  return timer1Micros();
+#endif
+}
 
 // Ângulos de evento
 // NOTA: Injeção precisa começar CEDO o suficiente para terminar antes do próximo gap!
@@ -32,18 +54,107 @@ volatile uint8_t revolutionCounter = 0;  // 0 ou 1 (para alternar cilindros)
 // SOLUÇÃO: Começar mais cedo, ex: 270° (90° BTDC)
 #define INJECTION_ANGLE 270   // 90° BTDC (garante término antes do TDC)
 
+// Injeção sequencial: canais ainda não agendados no ciclo atual (bit 0 =
+// canal 1). Recarregado na volta 0; na volta 1 todos já saíram.
+static uint8_t seqInjectionPending = 0;
+
+// Ignição ancorada no dente: os eventos agendados no gap a partir da
+// revolução anterior são reposicionados no último dente físico antes de cada
+// um, com o período do dente mais recente. O erro de previsão numa
+// aceleração fica limitado a um dente, em vez de uma revolução inteira.
+struct ToothAnchor {
+  uint8_t tooth;        // Último dente antes do evento (índice a partir do dente #1)
+  uint16_t offset;      // Do dente até o evento, em dentes Q8 (256 = 1 dente)
+};
+
+#define ANCHOR_CHARGE  0x01
+#define ANCHOR_SPARK   0x02
+
+static volatile IgnitionSchedule* anchorSchedule = nullptr;
+static ToothAnchor anchorCharge;          // Início do dwell
+static ToothAnchor anchorSpark;           // Faísca
+static uint8_t anchorPending = 0;         // ANCHOR_CHARGE | ANCHOR_SPARK ainda não reancorados
+
+// Timestamp do último dente na polaridade do dente #1 (base do toothPeriod)
+static uint32_t toothLastSameEdgeTime = 0;
+
+// Histórico curto dos períodos de dente (us, saturado em 16 bits), para
+// RPM instantâneo e aceleração angular. Potência de 2: o índice usa máscara.
+#define TOOTH_HISTORY  4
+
+static volatile uint16_t toothHistory[TOOTH_HISTORY];
+static volatile uint8_t toothHistoryIndex = 0;   // Próxima posição a escrever
+static volatile uint8_t toothHistoryFill = 0;    // Entradas válidas desde o sync
+
+// Tooth logger / composite logger. Intervalo em 16 bits (saturado) + status
+// em vez dos 4 bytes por entrada do Speeduino: cabe no orçamento de RAM do Uno.
+volatile uint8_t toothLogMode = TOOTH_LOG_OFF;
+static uint16_t toothLogGap[TOOTH_LOG_SIZE];
+static uint8_t toothLogFlags[TOOTH_LOG_SIZE];
+static volatile uint8_t toothLogIndex = 0;       // Próxima entrada; TOOTH_LOG_SIZE = cheio
+static uint32_t toothLogLastTime = 0;            // Última borda gravada (composite)
+
+// Recíprocos da geometria da roda, calculados no setup do decoder para que
+// a ISR troque divisões (~40us cada no AVR) por multiplicação + shift
+static uint32_t toothAngleRecip = 0;     // 2^22 / toothAngle
+static uint16_t teethRecip = 0;          // 2^16 / triggerTeeth
+static int8_t toothCenterDistance = 0;   // Dentes entre o centro do histórico e o da revolução
+static uint16_t toothCenterRecip = 0;    // 2^16 / toothCenterDistance
+
+// Ângulo (graus * 10) para dentes à frente em Q8
+static inline uint32_t angleToTeethQ8(uint16_t angle) {
+  return ((uint32_t)angle * toothAngleRecip) >> 14;
+}
+
+// Recalcula as escalas ângulo<->tempo da revolução: a única divisão que
+// sobra na ISR do trigger, uma vez por revolução
+static inline void updateRevolutionScale(uint32_t revolutionTime) {
+  // us por grau em Q8 = revolutionTime * 256 / 360 = revolutionTime * 46603 / 65536.
+  // Parte alta e baixa multiplicadas separadamente: nenhum produto passa de
+  // 32 bits para qualquer revolutionTime (primeiro pulso após parar, <41 RPM)
+  triggerState.usPerDegreeQ8 = (revolutionTime >> 16) * 46603UL +
+                               (((revolutionTime & 0xFFFFUL) * 46603UL + 0x8000UL) >> 16);
+  triggerState.degreesPerUsQ20 = (360UL << 20) / revolutionTime;
+}
+
+// Ângulo (graus) para tempo na velocidade média da última revolução
+static inline uint32_t angleToTimeAverage(uint16_t angle) {
+  return ((uint32_t)angle * triggerState.usPerDegreeQ8) >> 8;
+}
+
 // ============================================================================
 // FUNÇÕES INLINE PARA AGENDAMENTO RÁPIDO NA ISR
 // ============================================================================
 
-// Agenda injeção VIA POLLING - CHAMADO DIRETAMENTE DA ISR
+// Injeção sequencial de um canal: uma vez por ciclo de 720°, terminando
+// injEndAngle graus antes do PMS de compressão do cilindro (tdcAngle, no
+// ciclo contado a partir do dente #1 da volta 0). Agenda na volta em que a
+// injeção começa; se o início já passou (o PW cresceu e puxou o início para a
+// volta anterior), abre no próprio dente #1 em vez de pular o ciclo.
+static inline void scheduleSequentialInjection(volatile FuelSchedule* schedule, uint16_t tdcAngle,
+                                               uint16_t pw, uint8_t channel) {
+  uint8_t mask = 1 << (channel - 1);
+  if (!(seqInjectionPending & mask)) return;
+
+  uint16_t pwAngle = timeToAngle(pw);
+  if (pwAngle > 720) pwAngle = 720;
+
+  int16_t start = (int16_t)tdcAngle - (int16_t)configPage1.injEndAngle - (int16_t)pwAngle;
+  while (start < 0) start += 720;
+
+  uint16_t revStart = revolutionCounter ? 360 : 0;
+  if ((uint16_t)start >= revStart + 360) return;  // Começa na próxima volta
+
+  uint16_t angle = ((uint16_t)start > revStart) ? (uint16_t)start - revStart : 0;
+  setFuelSchedule(schedule, angleToTime(angle), pw, channel);
+  seqInjectionPending &= ~mask;
+}
+
+// Agenda injeção na fila do Timer1 - CHAMADO DIRETAMENTE DA ISR
 inline void scheduleInjectionISR() __attribute__((always_inline));
 inline void scheduleInjectionISR() {
   if (triggerState.revolutionTime == 0) return;
 
-  // Calcula tempo até ângulo de injeção
-  uint32_t timeToInjection = ((uint32_t)INJECTION_ANGLE * triggerState.revolutionTime) / 360UL;
-
   // Obtém PW (calculado no loop principal)
   uint16_t pw1 = currentStatus.PW1;
   uint16_t pw2 = currentStatus.PW2;
@@ -52,17 +163,48 @@ inline void scheduleInjectionISR() {
   if (pw1 < INJ_MIN_PW || pw1 > INJ_MAX_PW) pw1 = INJ_MIN_PW;
   if (pw2 < INJ_MIN_PW || pw2 > INJ_MAX_PW) pw2 = INJ_MIN_PW;
 
-  // Agenda VIA POLLING (não usa compare match)
+  // Sequencial: PMS de compressão do cilindro 1 no fim da volta 0 (é onde a
+  // bobina 1 faísca), o do cilindro 2 no fim da volta 1. Sem fase do ciclo
+  // (sensor ausente ou ainda não visto) cai no pareado abaixo.
+  if (configPage1.injectorLayout == INJ_LAYOUT_SEQUENTIAL && triggerState.hasCycleSync) {
+    if (revolutionCounter == 0) {
+      seqInjectionPending = (configPage1.nCylinders > 1) ? 0x03 : 0x01;
+    }
+    scheduleSequentialInjection(&fuelSchedule1, 360, pw1, 1);
+    scheduleSequentialInjection(&fuelSchedule2, 720, pw2, 2);
+    return;
+  }
+
+  // Calcula tempo até ângulo de injeção
+  uint32_t timeToInjection = angleToTime(INJECTION_ANGLE);
+
+  // Abertura e fechamento entram na fila de eventos (compare match)
   if (revolutionCounter == 0) {
     // Primeira revolução: banco 1
-    scheduleInjectorPolling(&injector1Polling, timeToInjection, pw1);
+    setFuelSchedule(&fuelSchedule1, timeToInjection, pw1, 1);
     // Canal 3 fica livre para estágio auxiliar (boost, metanol, etc.) - não agendado automaticamente
   } else {
     // Segunda revolução: banco 2
-    scheduleInjectorPolling(&injector2Polling, timeToInjection, pw2);
+    setFuelSchedule(&fuelSchedule2, timeToInjection, pw2, 2);
   }
 }
 
+// Acha o último dente físico antes do ângulo (graus * 10 após o dente #1).
+// Devolve false para eventos no próprio dente #1.
+static bool setToothAnchor(ToothAnchor& anchor, uint16_t angle) {
+  if (angle == 0) return false;
+
+  uint16_t teeth = angleToTeethQ8(angle);
+  uint16_t tooth = (teeth == 0) ? 0 : ((teeth - 1) >> 8);
+  if (tooth >= triggerState.triggerActualTeeth) {
+    tooth = triggerState.triggerActualTeeth - 1;  // Cai nos dentes faltantes
+  }
+
+  anchor.tooth = tooth;
+  anchor.offset = teeth - (tooth << 8);
+  return true;
+}
+
 // Agenda ignição - CHAMADO DIRETAMENTE DA ISR
 inline void scheduleIgnitionISR() __attribute__((always_inline));
 inline void scheduleIgnitionISR() {
@@ -77,13 +219,13 @@ inline void scheduleIgnitionISR() {
   if (dwellTime > DWELL_MAX) dwellTime = DWELL_MAX;
 
   // Calcula ângulo do dwell em graus
-  uint16_t dwellAngle = ((uint32_t)dwellTime * 360UL) / triggerState.revolutionTime;
+  uint16_t dwellAngle = timeToAngle(dwellTime);
 
   // PROTEÇÃO: Limita dwell a no máximo 50% da revolução (180°)
   if (dwellAngle > 180) {
     dwellAngle = 180;
     // Recalcula dwellTime baseado no ângulo limitado
-    dwellTime = (180UL * triggerState.revolutionTime) / 360UL;
+    dwellTime = triggerState.revolutionTime >> 1;
   }
 
   // Ângulo de faísca (advance é BTDC, então 360 - advance)
@@ -100,19 +242,128 @@ inline void scheduleIgnitionISR() {
     dwellStartAngle = 0;
     // Ajusta dwell para caber
     dwellAngle = sparkAngle;
-    dwellTime = (dwellAngle * triggerState.revolutionTime) / 360UL;
+    dwellTime = angleToTimeAverage(dwellAngle);
   }
 
   // Calcula tempo até início do dwell
-  uint32_t timeToDwell = ((uint32_t)dwellStartAngle * triggerState.revolutionTime) / 360UL;
+  uint32_t timeToDwell = angleToTime(dwellStartAngle);
 
   if (revolutionCounter == 0) {
     // Primeira revolução: bobina 1
     setIgnitionSchedule(&ignitionSchedule1, timeToDwell, dwellTime, 1);
+    anchorSchedule = &ignitionSchedule1;
 
   } else {
     // Segunda revolução: bobina 2
     setIgnitionSchedule(&ignitionSchedule2, timeToDwell, dwellTime, 2);
+    anchorSchedule = &ignitionSchedule2;
+  }
+
+  // Os dentes desta revolução vão refinar os dois eventos. Só a roda fônica
+  // tem dentes intermediários; distribuidor já agenda no único dente.
+  anchorPending = 0;
+  if (anchorSchedule->status != SCHED_OFF && triggerState.triggerActualTeeth > 1) {
+    if (setToothAnchor(anchorCharge, dwellStartAngle * 10)) anchorPending |= ANCHOR_CHARGE;
+    if (setToothAnchor(anchorSpark, sparkAngle * 10)) anchorPending |= ANCHOR_SPARK;
+  }
+}
+
+// Reposiciona um evento a partir do dente atual. No dente âncora o evento é
+// sempre reancorado; nos dentes anteriores só quando ele dispararia antes do
+// próprio dente âncora (desaceleração forte), para não se perder. Devolve
+// true quando o evento não precisa mais ser acompanhado.
+static inline bool anchorEvent(const ToothAnchor& anchor, uint8_t tooth, uint32_t toothTime,
+                               uint32_t scheduledTick, bool spark) {
+  if (tooth > anchor.tooth) return true;  // Dente âncora perdido
+
+  uint32_t teethAhead = (uint32_t)(anchor.tooth - tooth);
+  if (teethAhead > 0) {
+    uint32_t anchorToothTime = toothTime + teethAhead * triggerState.toothPeriod;
+    if ((int32_t)(scheduledTick - US_TO_SCHED_TICKS(anchorToothTime)) > 0) return false;
+  }
+
+  uint32_t delay = (((teethAhead << 8) + anchor.offset) * triggerState.toothPeriod) >> 8;
+  if (spark) {
+    retimeIgnitionSpark(anchorSchedule, toothTime + delay);
+  } else {
+    retimeIgnitionCharge(anchorSchedule, toothTime + delay);
+  }
+  return (teethAhead == 0);
+}
+
+// Atualiza período do dente atual (só bordas na polaridade do dente #1) e
+// reancora a ignição pendente.
+inline void trackToothISR(uint32_t curTime) __attribute__((always_inline));
+inline void trackToothISR(uint32_t curTime) {
+  uint16_t tooth = triggerState.toothCurrentCount - 1;  // Bordas desde o dente #1
+  if (triggerEdgesPerTooth == 2) {
+    if (tooth & 1) return;  // Borda oposta: duty do dente não é 50%, não serve de referência
+    tooth >>= 1;
+  }
+
+  uint32_t period = curTime - toothLastSameEdgeTime;
+  triggerState.toothPeriod = period;
+  toothLastSameEdgeTime = curTime;
+
+  toothHistory[toothHistoryIndex] = (period > 0xFFFF) ? 0xFFFF : (uint16_t)period;
+  toothHistoryIndex = (toothHistoryIndex + 1) & (TOOTH_HISTORY - 1);
+  if (toothHistoryFill < TOOTH_HISTORY) toothHistoryFill++;
+
+  if (anchorPending == 0) return;
+
+  // Faísca primeiro: empurrar a carga para depois da faísca antiga seria recusado
+  if ((anchorPending & ANCHOR_SPARK) &&
+      anchorEvent(anchorSpark, tooth, curTime, anchorSchedule->endTick, true)) {
+    anchorPending &= ~ANCHOR_SPARK;
+  }
+  if ((anchorPending & ANCHOR_CHARGE) &&
+      anchorEvent(anchorCharge, tooth, curTime, anchorSchedule->startTick, false)) {
+    anchorPending &= ~ANCHOR_CHARGE;
+  }
+}
+
+// Avança a volta do ciclo no dente #1. Com sensor de fase, o pulso do comando
+// cai na volta 1 e a volta seguinte é sempre a 0; um ciclo sem pulso derruba
+// a fase (volta ao pareado/wasted) até o próximo pulso.
+static inline void advanceCyclePhase() {
+  revolutionCounter ^= 1;
+
+  if (triggerState.camPulse) {
+    triggerState.camPulse = false;
+    revolutionCounter = 0;
+    triggerState.hasCycleSync = true;
+  } else if (revolutionCounter == 0) {
+    triggerState.hasCycleSync = false;
+  }
+}
+
+// Grava uma borda no tooth logger. Só é chamada com toothLogMode ligado; com
+// o buffer cheio não faz nada até o TunerStudio ler e liberar ('T').
+static void toothLogRecord(uint32_t curTime, uint8_t flags) {
+  uint8_t i = toothLogIndex;
+  if (i >= TOOTH_LOG_SIZE) return;
+
+  // Tooth log: intervalo entre dentes aceitos, como o decoder viu.
+  // Composite: intervalo desde a borda anterior, aceita ou não.
+  uint32_t gap = (toothLogMode == TOOTH_LOG_TOOTH) ? triggerState.curGap
+                                                   : (curTime - toothLogLastTime);
+  toothLogLastTime = curTime;
+
+  if (FastPin<PIN_TRIGGER_PRIMARY>::read()) flags |= (1 << TOOTH_LOG_PRI_LEVEL);
+  if (triggerState.hasSync) flags |= (1 << TOOTH_LOG_SYNC);
+  if (configPage2.camInput != CAM_INPUT_OFF && FastPin<PIN_TRIGGER_SECONDARY>::read()) {
+    flags |= (1 << TOOTH_LOG_SEC_LEVEL);
+  }
+
+  toothLogGap[i] = (gap > 0xFFFF) ? 0xFFFF : (uint16_t)gap;
+  toothLogFlags[i] = flags;
+  toothLogIndex = i + 1;
+}
+
+// Borda descartada pelos filtros: só interessa ao composite logger
+static inline void toothLogRejected(uint32_t curTime) {
+  if (toothLogMode == TOOTH_LOG_COMPOSITE) {
+    toothLogRecord(curTime, 0);
   }
 }
 
@@ -166,6 +417,12 @@ void triggerSetup_MissingTooth() {
   // Total de dentes na roda (incluindo faltantes)
   triggerState.toothTotalCount = triggerState.triggerTeeth;
 
+  // Recíprocos usados pela ISR (divisões só aqui, fora do tempo real)
+  toothAngleRecip = (1UL << 22) / triggerState.toothAngle;
+  teethRecip = (triggerState.triggerTeeth > 1) ? (uint16_t)(0x10000UL / triggerState.triggerTeeth) : 0;
+  toothCenterDistance = (int8_t)((triggerState.triggerTeeth >> 1) - (TOOTH_HISTORY / 2) - triggerState.triggerMissing);
+  toothCenterRecip = (toothCenterDistance >= 4) ? (uint16_t)(0x10000UL / toothCenterDistance) : 0;
+
   // Define ISR
   currentTriggerISR = triggerPri_MissingTooth;
 
@@ -189,6 +446,8 @@ void triggerSetup_BasicDistributor() {
 
   triggerState.toothTotalCount = 1;
 
+  toothCenterDistance = 0;  // Sem dentes intermediários: só velocidade média
+
   currentTriggerISR = triggerPri_BasicDistributor;
 
   DEBUG_PRINTLN(F("Basic Distributor"));
@@ -202,20 +461,22 @@ void triggerPri_MissingTooth() {
   // CRÍTICO: código deve ser extremamente rápido!
 
   // Timestamp atual
-  uint32_t curTime = micros();
+  uint32_t curTime = triggerEdgeTime();
 
   // Gap desde último dente
   triggerState.curGap = curTime - triggerState.toothLastToothTime;
 
   // Filtro de debounce mínimo (50us absoluto - bounce de contato/EMI)
   if (triggerState.curGap < 50) {
+    toothLogRejected(curTime);
     return;  // Ignora ruído
   }
 
   // Rejeita pulso muito curto em relação à referência (ex: ruído de ignição/EMI
   // causando double-trigger). Independente do filtro absoluto acima, que não
   // pega ruído rápido em RPMs altos onde o gap normal já é pequeno.
-  if (triggerState.lastGap > 0 && triggerState.curGap < (triggerState.lastGap / 3)) {
+  if (triggerState.lastGap > 0 && (triggerState.curGap * 3) < triggerState.lastGap) {
+    toothLogRejected(curTime);
     return;  // Ignora ruído
   }
 
@@ -237,6 +498,10 @@ void triggerPri_MissingTooth() {
   if (triggerState.toothCurrentCount > (triggerState.toothTotalCount * 2)) {
     triggerState.toothCurrentCount = 1;
     triggerState.hasSync = false;
+    triggerState.hasCycleSync = false;
+    triggerState.toothLastMinusOneTime = 0;
+    triggerState.revolutionTime = 0;
+    toothHistoryFill = 0;
   }
 
   // Motor em cranking tem período mais instável entre dentes (partida manual,
@@ -248,8 +513,8 @@ void triggerPri_MissingTooth() {
   // Gap normal ≈ gap anterior; missing tooth precisa ser pelo menos 1.5x maior
   // (1.4x durante cranking, para tolerar mais jitter no sinal)
   uint32_t baseGap = (triggerState.lastGap > 0) ? triggerState.lastGap : triggerState.curGap;
-  uint32_t dynamicThreshold = isCranking ? (baseGap + ((baseGap * 2) / 5))  // 1.4x
-                                          : (baseGap + (baseGap >> 1));     // 1.5x
+  uint32_t dynamicThreshold = isCranking ? (baseGap + ((baseGap * 13) >> 5))  // ~1.4x
+                                          : (baseGap + (baseGap >> 1));       // 1.5x
   bool isGap = (triggerState.curGap > dynamicThreshold);
 
   if (isGap) {
@@ -274,14 +539,18 @@ void triggerPri_MissingTooth() {
       // Calcula tempo de revolução (desde último gap)
       if (triggerState.toothLastMinusOneTime > 0) {
         triggerState.revolutionTime = curTime - triggerState.toothLastMinusOneTime;
+        updateRevolutionScale(triggerState.revolutionTime);
       }
       triggerState.toothLastMinusOneTime = curTime;
 
       // Reseta contador
       triggerState.toothCurrentCount = 1;
+      toothLastSameEdgeTime = curTime;
 
-      // Alterna revolução (para sequenciamento wasted paired)
-      revolutionCounter = (revolutionCounter == 0) ? 1 : 0;
+      // Alterna revolução (fase do ciclo com sensor de fase, senão wasted paired)
+      advanceCyclePhase();
+      mapCycleMark();
+      triggerNewCycle = true;
 
       // *** AGENDAMENTO DIRETO NA ISR - TEMPO REAL! ***
       if (triggerState.revolutionTime > 0) {
@@ -295,12 +564,27 @@ void triggerPri_MissingTooth() {
 
       if (triggerState.syncLossCounter > 10) {
         triggerState.hasSync = false;
+        triggerState.hasCycleSync = false;
+        triggerState.toothLastMinusOneTime = 0;
+        triggerState.revolutionTime = 0;
+        toothHistoryFill = 0;
       }
     }
+  } else if (triggerState.hasSync) {
+    trackToothISR(curTime);
+  }
+
+  // Atualiza lastGap para referência. O intervalo do gap não entra: com ele
+  // o filtro de ruído (lastGap / 3) descartaria o dente seguinte nas rodas
+  // com 2+ dentes faltantes ou com ambas as bordas, e a contagem de dentes
+  // (usada para o ângulo de cada dente) ficaria deslocada.
+  if (!isGap) {
+    triggerState.lastGap = triggerState.curGap;
   }
 
-  // Atualiza lastGap para referência
-  triggerState.lastGap = triggerState.curGap;
+  if (toothLogMode) {
+    toothLogRecord(curTime, (1 << TOOTH_LOG_TRIGGER));
+  }
 }
 
 // ============================================================================
@@ -308,12 +592,13 @@ void triggerPri_MissingTooth() {
 // ============================================================================
 
 void triggerPri_BasicDistributor() {
-  uint32_t curTime = micros();
+  uint32_t curTime = triggerEdgeTime();
 
   triggerState.curGap = curTime - triggerState.toothLastToothTime;
 
   // Filtro de debounce
   if (triggerState.curGap < triggerState.triggerFilterTime) {
+    toothLogRejected(curTime);
     return;
   }
 
@@ -324,17 +609,39 @@ void triggerPri_BasicDistributor() {
 
   // Tempo de revolução
   triggerState.revolutionTime = triggerState.curGap;
+  updateRevolutionScale(triggerState.revolutionTime);
 
   // Atualiza histórico
   triggerState.toothLastToothTime = curTime;
   triggerState.toothLastMinusOneTime = curTime;
 
   // Alterna revolução
-  revolutionCounter = (revolutionCounter == 0) ? 1 : 0;
+  advanceCyclePhase();
+  mapCycleMark();
+  triggerNewCycle = true;
 
   // *** AGENDAMENTO DIRETO NA ISR - TEMPO REAL! ***
   scheduleInjectionISR();
   scheduleIgnitionISR();
+
+  if (toothLogMode) {
+    toothLogRecord(curTime, (1 << TOOTH_LOG_TRIGGER));
+  }
+}
+
+// ============================================================================
+// ISR: SENSOR DE FASE (COMANDO)
+// ============================================================================
+
+void triggerSec_Cam() {
+  // Só com o virabrequim sincronizado: ruído no cabo parado não vale como fase
+  if (triggerState.hasSync) {
+    triggerState.camPulse = true;
+  }
+
+  if (toothLogMode == TOOTH_LOG_COMPOSITE) {
+    toothLogRecord(timer1Micros(), 0);
+  }
 }
 
 // ============================================================================
@@ -346,6 +653,8 @@ void calculateRPM() {
   if (!triggerState.hasSync) {
     triggerState.RPM = 0;
     currentStatus.RPM = 0;
+    currentStatus.rpmDOT = 0;
+    currentStatus.RPMinstant = 0;
     currentStatus.hasSync = false;
     return;
   }
@@ -363,15 +672,75 @@ void calculateRPM() {
 
     triggerState.RPM = (uint16_t)rpm;
 
+    int16_t rpmDOT = calculateRPMdot();
+
     // Atualiza status global (thread-safe)
     noInterrupts();
     currentStatus.RPM = triggerState.RPM;
+    currentStatus.rpmDOT = rpmDOT;
     currentStatus.hasSync = true;
     interrupts();
   } else {
     triggerState.RPM = 0;
     currentStatus.RPM = 0;
+    currentStatus.rpmDOT = 0;
+    currentStatus.RPMinstant = 0;
+  }
+}
+
+// ============================================================================
+// RPM INSTANTÂNEO E ACELERAÇÃO ANGULAR
+// ============================================================================
+
+// Tempo (us) dos últimos TOOTH_HISTORY dentes, 0 se ainda não há histórico
+// completo desde o sync. A soma de períodos consecutivos se cancela: sobra o
+// erro de quantização de só dois timestamps, não de cada dente. Chamar com
+// interrupções desabilitadas (ou da ISR).
+static inline uint32_t toothHistoryTime() {
+  if (toothHistoryFill < TOOTH_HISTORY) return 0;
+
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < TOOTH_HISTORY; i++) {
+    total += toothHistory[i];
   }
+  return total;
+}
+
+uint16_t getInstantRPM() {
+  noInterrupts();
+  uint32_t historyTime = toothHistoryTime();
+  interrupts();
+
+  if (historyTime == 0 || triggerState.triggerTeeth == 0) {
+    return currentStatus.RPM;  // Distribuidor ou recém sincronizado
+  }
+
+  uint32_t rpm = ((uint32_t)TOOTH_HISTORY * MICROS_PER_MIN) / (historyTime * triggerState.triggerTeeth);
+  return (rpm > 15000) ? 15000 : (uint16_t)rpm;
+}
+
+int16_t calculateRPMdot() {
+  noInterrupts();
+  uint32_t historyTime = toothHistoryTime();
+  uint32_t revolutionTime = triggerState.revolutionTime;
+  uint32_t sinceToothOne = toothLastSameEdgeTime - triggerState.toothOneTime;
+  interrupts();
+
+  if (historyTime == 0 || revolutionTime <= historyTime) return 0;
+
+  // RPM dos últimos dentes contra a média da última revolução. A distância
+  // entre os centros das duas janelas é a base de tempo da derivada: meia
+  // revolução, longa o bastante para o erro de quantização do Timer1 (16us
+  // em baixa rotação) não virar ruído na aceleração.
+  int32_t rpmNow = getInstantRPM();
+  int32_t rpmRev = MICROS_PER_MIN / revolutionTime;
+  uint32_t span = sinceToothOne + ((revolutionTime - historyTime) >> 1);
+  if ((span >> 6) == 0) return 0;
+
+  int32_t rpmDOT = ((rpmNow - rpmRev) * 15625L) / (int32_t)(span >> 6);  // 1e6 = 15625 * 64
+  if (rpmDOT > 32767) rpmDOT = 32767;
+  if (rpmDOT < -32767) rpmDOT = -32767;
+  return (int16_t)rpmDOT;
 }
 
 // ============================================================================
@@ -380,14 +749,22 @@ void calculateRPM() {
 
 void checkSyncLoss() {
   // Se não recebeu dentes por muito tempo, perde sync
-  uint32_t timeSinceLastTooth = micros() - triggerState.toothLastToothTime;
+  uint32_t timeSinceLastTooth = timer1Micros() - triggerState.toothLastToothTime;
 
   if (timeSinceLastTooth > (SYNC_TIMEOUT * 1000UL)) {
     // Timeout!
     noInterrupts();
     triggerState.hasSync = false;
+    triggerState.hasCycleSync = false;
+    // Sem isso a primeira volta após ressincronizar mediria desde o último
+    // dente #1 antes da parada, e agendaria com essa "revolução" de segundos
+    triggerState.toothLastMinusOneTime = 0;
+    triggerState.revolutionTime = 0;
+    toothHistoryFill = 0;
     currentStatus.hasSync = false;
     currentStatus.RPM = 0;
+    currentStatus.rpmDOT = 0;
+    currentStatus.RPMinstant = 0;
     interrupts();
   }
 }
@@ -400,21 +777,60 @@ uint32_t angleToTime(uint16_t angle) {
   // Tempo = (ângulo / 360) * revolutionTime
   if (triggerState.revolutionTime == 0) return 0;
 
-  return ((uint32_t)angle * triggerState.revolutionTime) / 360UL;
+  // Sem histórico de dentes (distribuidor, recém sincronizado), roda com
+  // poucos dentes ou cranking (o período oscila a cada compressão):
+  // velocidade constante na média da última revolução
+  uint32_t historyTime = toothHistoryTime();
+  bool isCranking = (currentStatus.RPM < ((uint16_t)configPage1.crankRPM * 10));
+  if (isCranking || historyTime == 0 || toothCenterDistance < 4) {
+    return angleToTimeAverage(angle);
+  }
+
+  // Tendência do período por dente: média dos últimos TOOTH_HISTORY dentes
+  // contra a média da revolução, cujos centros estão toothCenterDistance
+  // dentes distantes. O período "agora" é o dos últimos dentes extrapolado
+  // até o dente #1, e n dentes à frente levam n*P + d*n^2/2.
+  uint32_t revolutionTime = triggerState.revolutionTime;
+  int32_t recent = (int32_t)(historyTime / TOOTH_HISTORY);
+  int32_t average = (revolutionTime < 0x10000UL)
+                    ? (int32_t)((revolutionTime * teethRecip) >> 16)
+                    : (int32_t)(((revolutionTime >> 4) * teethRecip) >> 12);
+  // Arredondado: o shift puro arredondava -0,1us/dente para -1us/dente, e o
+  // termo quadrático transformava esse ruído em ~2% de erro a rotação constante
+  int32_t delta = ((recent - average) * (int32_t)toothCenterRecip + 0x8000L) >> 16;
+  if (delta > 2047) delta = 2047;
+  if (delta < -2047) delta = -2047;
+  int32_t period = recent + delta * (TOOTH_HISTORY / 2 + triggerState.triggerMissing);
+  if (period <= 0) period = recent;
+
+  uint32_t toothQ8 = angleToTeethQ8(angle * 10);  // Dentes à frente, Q8
+  uint32_t time = (toothQ8 * (uint32_t)period) >> 8;
+  int32_t trend = (delta * (int32_t)((toothQ8 * toothQ8) >> 8)) >> 9;
+
+  // Tendência é extrapolação: limitada a 25% do tempo a velocidade constante
+  int32_t limit = (int32_t)(time >> 2);
+  if (trend > limit) trend = limit;
+  if (trend < -limit) trend = -limit;
+
+  return (uint32_t)((int32_t)time + trend);
 }
 
 uint16_t timeToAngle(uint32_t time) {
   // Ângulo = (tempo / revolutionTime) * 360
   if (triggerState.revolutionTime == 0) return 0;
 
-  return (uint16_t)(((uint32_t)time * 360UL) / triggerState.revolutionTime);
+  // Q20 estoura acima de ~11 revoluções
+  uint32_t maxTime = triggerState.revolutionTime << 3;
+  if (time > maxTime) time = maxTime;
+
+  return (uint16_t)((time * triggerState.degreesPerUsQ20) >> 20);
 }
 
 uint16_t getCrankAngle() {
   if (!triggerState.hasSync || triggerState.revolutionTime == 0) return 0;
 
   // Tempo desde dente #1
-  uint32_t timeSinceToothOne = micros() - triggerState.toothOneTime;
+  uint32_t timeSinceToothOne = timer1Micros() - triggerState.toothOneTime;
 
   // Limita ao tempo de revolução para evitar overflow e operação módulo
   // (entre revoluções o tempo pode exceder revolutionTime)
@@ -423,7 +839,12 @@ uint16_t getCrankAngle() {
   }
 
   // Converte para ângulo (0-359) - agora garantido sem necessidade de módulo
-  uint16_t angle = ((uint32_t)timeSinceToothOne * 360UL) / triggerState.revolutionTime;
+  uint16_t angle = (timeSinceToothOne * triggerState.degreesPerUsQ20) >> 20;
+
+  // Com a fase do ciclo conhecida, a volta 1 é a segunda metade dos 720°
+  if (triggerState.hasCycleSync && revolutionCounter == 1) {
+    angle += 360;
+  }
 
   return angle;
 }
@@ -453,6 +874,25 @@ void attachTriggerInterrupt() {
       break;
   }
 
+#if defined(TRIGGER_USE_ICP1)
+  // Input capture do Timer1 (ICP1 - D8). O noise canceler (ICNC1) exige 4
+  // amostras iguais antes de aceitar a borda: 0,25us de atraso fixo, que some
+  // nas diferenças entre dentes.
+  uint8_t oldSREG = SREG;
+  cli();
+  triggerCaptureBothEdges = (interruptMode == CHANGE);
+  TCCR1B |= (1 << ICNC1);
+  bool risingEdge = (interruptMode == RISING) ||
+                    (interruptMode == CHANGE && digitalRead(PIN_TRIGGER_PRIMARY) == LOW);
+  if (risingEdge) {
+    TCCR1B |= (1 << ICES1);
+  } else {
+    TCCR1B &= ~(1 << ICES1);
+  }
+  TIFR1 = (1 << ICF1);  // Trocar ICES1 pode ligar ICF1
+  TIMSK1 |= (1 << ICIE1);
+  SREG = oldSREG;
+#else
   // Anexa interrupção INT0 (pino D2 no Uno/Nano - PIN_TRIGGER_PRIMARY)
   // Pode ser RISING, FALLING ou CHANGE (ambas as bordas)
   // NOTA: Com CHANGE, cada dente físico gera 2 pulsos!
@@ -462,11 +902,45 @@ void attachTriggerInterrupt() {
       currentTriggerISR();
     }
   }, interruptMode);
+#endif
+
+  // Sensor de fase (comando) no INT1: 1 pulso por ciclo de 720°
+  if (configPage2.camInput != CAM_INPUT_OFF) {
+    pinMode(PIN_TRIGGER_SECONDARY, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(PIN_TRIGGER_SECONDARY), triggerSec_Cam,
+                    (configPage2.camEdge == TRIGGER_EDGE_FALLING) ? FALLING : RISING);
+  }
 }
 
 void detachTriggerInterrupt() {
+#if defined(TRIGGER_USE_ICP1)
+  TIMSK1 &= ~(1 << ICIE1);
+#else
   detachInterrupt(digitalPinToInterrupt(PIN_TRIGGER_PRIMARY));
+#endif
+  detachInterrupt(digitalPinToInterrupt(PIN_TRIGGER_SECONDARY));
+}
+
+#if defined(TRIGGER_USE_ICP1)
+// ============================================================================
+// ISR: INPUT CAPTURE DO TIMER1 (TRIGGER_USE_ICP1)
+// ============================================================================
+// Tem prioridade sobre os compares e o overflow do Timer1. O ICR1 guarda o
+// instante exato da borda, independente de quanto a ISR demorou a entrar.
+
+ISR(TIMER1_CAPT_vect) {
+  triggerCaptureTime = timer1CaptureMicros(ICR1);
+
+  if (triggerCaptureBothEdges) {
+    TCCR1B ^= (1 << ICES1);
+    TIFR1 = (1 << ICF1);  // Trocar ICES1 pode ligar ICF1
+  }
+
+  if (currentTriggerISR != nullptr) {
+    currentTriggerISR();
+  }
 }
+#endif
 
 void resetTriggerState() {
   noInterrupts();
@@ -474,6 +948,8 @@ void resetTriggerState() {
   triggerState.toothLastToothTime = 0;
   triggerState.toothLastMinusOneTime = 0;
   triggerState.revolutionTime = 0;
+  triggerState.usPerDegreeQ8 = 0;
+  triggerState.degreesPerUsQ20 = 0;
   triggerState.toothOneTime = 0;
 
   triggerState.toothCurrentCount = 0;
@@ -484,9 +960,14 @@ void resetTriggerState() {
   triggerState.lastGap = 0;
   triggerState.hasSync = false;
   triggerState.syncLossCounter = 0;
+  triggerState.hasCycleSync = false;
+  triggerState.camPulse = false;
 
   triggerState.RPM = 0;
   triggerState.toothPeriod = 0;
+  toothLastSameEdgeTime = 0;
+  anchorPending = 0;
+  toothHistoryFill = 0;
 
   currentStatus.hasSync = false;
   currentStatus.RPM = 0;
@@ -495,3 +976,32 @@ void resetTriggerState() {
 
   interrupts();
 }
+
+// ============================================================================
+// TOOTH LOGGER / COMPOSITE LOGGER
+// ============================================================================
+
+void toothLoggerStart(uint8_t mode) {
+  noInterrupts();
+  toothLogIndex = 0;
+  toothLogMode = mode;
+  interrupts();
+}
+
+void toothLoggerStop() {
+  toothLogMode = TOOTH_LOG_OFF;
+}
+
+bool toothLogReady() {
+  return (toothLogMode != TOOTH_LOG_OFF) && (toothLogIndex >= TOOTH_LOG_SIZE);
+}
+
+uint8_t toothLogEntry(uint8_t index, uint16_t& gap) {
+  // Buffer cheio: a ISR não escreve mais nele até toothLogRestart()
+  gap = toothLogGap[index];
+  return toothLogFlags[index];
+}
+
+void toothLogRestart() {
+  toothLogIndex = 0;
+}
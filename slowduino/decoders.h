@@ -22,6 +22,8 @@ struct TriggerState {
   volatile uint32_t toothLastToothTime;    // Timestamp do último dente (micros)
   volatile uint32_t toothLastMinusOneTime; // Timestamp do penúltimo dente
   volatile uint32_t revolutionTime;        // Duração da última revolução (micros)
+  volatile uint32_t usPerDegreeQ8;         // revolutionTime / 360 (us por grau, Q8)
+  volatile uint32_t degreesPerUsQ20;       // 360 / revolutionTime (graus por us, Q20)
   volatile uint32_t toothOneTime;          // Timestamp do dente #1 (referência)
 
   // Contadores
@@ -35,9 +37,13 @@ struct TriggerState {
   volatile bool hasSync;                   // Motor sincronizado?
   volatile uint8_t syncLossCounter;        // Contador de falhas de sync
 
+  // Ciclo de 720° (sensor de fase no comando)
+  volatile bool hasCycleSync;              // Fase do ciclo conhecida (revolutionCounter válido)
+  volatile bool camPulse;                  // Pulso de fase visto desde o último dente #1
+
   // RPM
   volatile uint16_t RPM;                   // RPM atual
-  volatile uint32_t toothPeriod;           // Período médio entre dentes (micros)
+  volatile uint32_t toothPeriod;           // Período do último dente (micros, mesma polaridade)
 
   // Configuração
   uint8_t triggerTeeth;                    // Total de dentes (incluindo faltantes)
@@ -48,6 +54,10 @@ struct TriggerState {
 
 extern volatile struct TriggerState triggerState;
 
+// Marcado pelo decoder no dente #1 (com sincronismo) e limpo pelo loop, que
+// recalcula PW, avanço e dwell uma vez por volta em vez de a cada passada
+extern volatile bool triggerNewCycle;
+
 // ============================================================================
 // FUNÇÕES PÚBLICAS
 // ============================================================================
@@ -86,6 +96,14 @@ void triggerPri_MissingTooth();
  */
 void triggerPri_BasicDistributor();
 
+/**
+ * @brief ISR do sensor de fase (comando)
+ *
+ * Chamada por INT1 (pino D3 - PIN_TRIGGER_SECONDARY). Só marca o pulso: a
+ * fase do ciclo é decidida no próximo dente #1 do virabrequim.
+ */
+void triggerSec_Cam();
+
 /**
  * @brief Calcula RPM baseado no período de revolução
  *
@@ -93,6 +111,25 @@ void triggerPri_BasicDistributor();
  */
 void calculateRPM();
 
+/**
+ * @brief RPM instantâneo, pelos últimos TOOTH_HISTORY dentes
+ *
+ * Soma os períodos do histórico de dentes (4 dentes), contra a média de uma
+ * revolução do currentStatus.RPM. Sem histórico completo (distribuidor,
+ * recém sincronizado) devolve o RPM médio. Chamar do loop.
+ */
+uint16_t getInstantRPM();
+
+/**
+ * @brief Aceleração angular (RPM/s) pelos últimos dentes
+ *
+ * Compara o RPM instantâneo (getInstantRPM(), últimos 4 dentes) com a média
+ * da última revolução; a base de tempo é a distância entre os centros das
+ * duas janelas, cerca de meia revolução. Usado por calculateRPM() para
+ * preencher currentStatus.rpmDOT.
+ */
+int16_t calculateRPMdot();
+
 /**
  * @brief Verifica timeout de sincronismo
  *
@@ -104,7 +141,11 @@ void checkSyncLoss();
 /**
  * @brief Converte ângulo para tempo (microsegundos)
  *
- * @param angle Ângulo em graus
+ * Em roda fônica fora do cranking, prevê a partir do período do último
+ * dente e da tendência dos anteriores (aceleração), em vez de assumir a
+ * velocidade média da última revolução. Pode ser chamada da ISR.
+ *
+ * @param angle Ângulo em graus a partir do dente atual
  * @return Tempo em microsegundos no RPM atual
  */
 uint32_t angleToTime(uint16_t angle);
@@ -121,7 +162,8 @@ uint16_t timeToAngle(uint32_t time);
  * @brief Retorna ângulo atual do virabrequim
  *
  * Calcula posição baseada no último dente e tempo decorrido
- * @return Ângulo em graus (0-359 para 2-stroke, 0-719 para 4-stroke)
+ * @return Ângulo em graus: 0-719 no ciclo com sensor de fase sincronizado,
+ *         0-359 sem ele
  */
 uint16_t getCrankAngle();
 
@@ -132,7 +174,8 @@ uint16_t getCrankAngle();
 /**
  * @brief Anexa interrupção ao pino de trigger
  *
- * Configura INT0 (pino D2 - PIN_TRIGGER_PRIMARY) com a ISR apropriada
+ * Configura INT0 (pino D2 - PIN_TRIGGER_PRIMARY) com a ISR apropriada e,
+ * com configPage2.camInput ligado, INT1 (pino D3) para o sensor de fase.
  */
 void attachTriggerInterrupt();
 
@@ -148,4 +191,58 @@ void detachTriggerInterrupt();
  */
 void resetTriggerState();
 
+// ============================================================================
+// TOOTH LOGGER / COMPOSITE LOGGER
+// ============================================================================
+// A ISR do trigger grava os intervalos crus num buffer em RAM até encher
+// (TOOTH_LOG_SIZE entradas). O TunerStudio lê com 'T' e a captura recomeça.
+// Desligado, o custo na ISR é só o teste de toothLogMode.
+
+enum ToothLogMode : uint8_t {
+  TOOTH_LOG_OFF,
+  TOOTH_LOG_TOOTH,       // Só dentes aceitos pelo decoder (intervalo entre eles)
+  TOOTH_LOG_COMPOSITE    // Todas as bordas, inclusive as filtradas, com níveis e sync
+};
+
+// Bits do byte de status de cada entrada do composite logger (layout Speeduino)
+#define TOOTH_LOG_PRI_LEVEL   0   // Nível do sinal primário após a borda
+#define TOOTH_LOG_SEC_LEVEL   1   // Nível do sinal secundário (cam)
+#define TOOTH_LOG_TRIGGER     3   // Borda aceita como dente pelo decoder
+#define TOOTH_LOG_SYNC        4   // Decoder sincronizado
+
+extern volatile uint8_t toothLogMode;
+
+/**
+ * @brief Liga o tooth logger ou o composite logger
+ *
+ * Descarta o que estava no buffer e começa uma nova captura.
+ *
+ * @param mode TOOTH_LOG_TOOTH ou TOOTH_LOG_COMPOSITE
+ */
+void toothLoggerStart(uint8_t mode);
+
+/**
+ * @brief Desliga a captura (a ISR volta a custar só um teste)
+ */
+void toothLoggerStop();
+
+/**
+ * @brief Buffer cheio, pronto para ser enviado ao TunerStudio
+ */
+bool toothLogReady();
+
+/**
+ * @brief Lê uma entrada do buffer (só válido com toothLogReady())
+ *
+ * @param index Entrada (0 a TOOTH_LOG_SIZE - 1, da mais antiga para a mais nova)
+ * @param gap Intervalo desde a entrada anterior (us, saturado em 65535)
+ * @return Byte de status (bits TOOTH_LOG_*)
+ */
+uint8_t toothLogEntry(uint8_t index, uint16_t& gap);
+
+/**
+ * @brief Libera o buffer já enviado para uma nova captura
+ */
+void toothLogRestart();
+
 #endif // DECODERS_H
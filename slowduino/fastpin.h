@@ -0,0 +1,150 @@
+/**
+ * @file fastpin.h
+ * @brief Acesso direto a pinos digitais resolvido em tempo de compilação
+ *
+ * FastPin<PIN_X> traduz o número de pino Arduino definido em board_config.h
+ * para o registrador PORTx e a máscara do bit em tempo de compilação.
+ * high()/low() viram um único sbi/cbi (~0.125us) nas portas de I/O baixas,
+ * contra ~4us do digitalWrite(), que consulta tabelas em PROGMEM, desliga o
+ * PWM do pino e desabilita interrupções a cada chamada.
+ */
+
+#ifndef FASTPIN_H
+#define FASTPIN_H
+
+#include <Arduino.h>
+#include "board_config.h"
+
+// ============================================================================
+// MAPA PINO -> PORTA/BIT
+// ============================================================================
+
+enum FastPort : uint8_t {
+  FASTPORT_NONE,
+  FASTPORT_A, FASTPORT_B, FASTPORT_C, FASTPORT_D, FASTPORT_E, FASTPORT_F,
+  FASTPORT_G, FASTPORT_H, FASTPORT_J, FASTPORT_K, FASTPORT_L
+};
+
+// Porta nos bits 7:3, número do bit nos bits 2:0
+#define FASTPIN_DEF(port, bit)  ((uint8_t)((FASTPORT_##port << 3) | (bit)))
+
+#if defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+// Mesma ordem do pins_arduino.h (variante "mega") - D0 a D69
+constexpr uint8_t FASTPIN_MAP[] = {
+  FASTPIN_DEF(E, 0), FASTPIN_DEF(E, 1), FASTPIN_DEF(E, 4), FASTPIN_DEF(E, 5),   // D0-D3
+  FASTPIN_DEF(G, 5), FASTPIN_DEF(E, 3), FASTPIN_DEF(H, 3), FASTPIN_DEF(H, 4),   // D4-D7
+  FASTPIN_DEF(H, 5), FASTPIN_DEF(H, 6), FASTPIN_DEF(B, 4), FASTPIN_DEF(B, 5),   // D8-D11
+  FASTPIN_DEF(B, 6), FASTPIN_DEF(B, 7), FASTPIN_DEF(J, 1), FASTPIN_DEF(J, 0),   // D12-D15
+  FASTPIN_DEF(H, 1), FASTPIN_DEF(H, 0), FASTPIN_DEF(D, 3), FASTPIN_DEF(D, 2),   // D16-D19
+  FASTPIN_DEF(D, 1), FASTPIN_DEF(D, 0), FASTPIN_DEF(A, 0), FASTPIN_DEF(A, 1),   // D20-D23
+  FASTPIN_DEF(A, 2), FASTPIN_DEF(A, 3), FASTPIN_DEF(A, 4), FASTPIN_DEF(A, 5),   // D24-D27
+  FASTPIN_DEF(A, 6), FASTPIN_DEF(A, 7), FASTPIN_DEF(C, 7), FASTPIN_DEF(C, 6),   // D28-D31
+  FASTPIN_DEF(C, 5), FASTPIN_DEF(C, 4), FASTPIN_DEF(C, 3), FASTPIN_DEF(C, 2),   // D32-D35
+  FASTPIN_DEF(C, 1), FASTPIN_DEF(C, 0), FASTPIN_DEF(D, 7), FASTPIN_DEF(G, 2),   // D36-D39
+  FASTPIN_DEF(G, 1), FASTPIN_DEF(G, 0), FASTPIN_DEF(L, 7), FASTPIN_DEF(L, 6),   // D40-D43
+  FASTPIN_DEF(L, 5), FASTPIN_DEF(L, 4), FASTPIN_DEF(L, 3), FASTPIN_DEF(L, 2),   // D44-D47
+  FASTPIN_DEF(L, 1), FASTPIN_DEF(L, 0), FASTPIN_DEF(B, 3), FASTPIN_DEF(B, 2),   // D48-D51
+  FASTPIN_DEF(B, 1), FASTPIN_DEF(B, 0),                                         // D52-D53
+  FASTPIN_DEF(F, 0), FASTPIN_DEF(F, 1), FASTPIN_DEF(F, 2), FASTPIN_DEF(F, 3),   // A0-A3
+  FASTPIN_DEF(F, 4), FASTPIN_DEF(F, 5), FASTPIN_DEF(F, 6), FASTPIN_DEF(F, 7),   // A4-A7
+  FASTPIN_DEF(K, 0), FASTPIN_DEF(K, 1), FASTPIN_DEF(K, 2), FASTPIN_DEF(K, 3),   // A8-A11
+  FASTPIN_DEF(K, 4), FASTPIN_DEF(K, 5), FASTPIN_DEF(K, 6), FASTPIN_DEF(K, 7)    // A12-A15
+};
+#else
+// ATmega328p/168 (Uno/Nano) - D0 a D19 (A6/A7 são só analógicos)
+constexpr uint8_t FASTPIN_MAP[] = {
+  FASTPIN_DEF(D, 0), FASTPIN_DEF(D, 1), FASTPIN_DEF(D, 2), FASTPIN_DEF(D, 3),   // D0-D3
+  FASTPIN_DEF(D, 4), FASTPIN_DEF(D, 5), FASTPIN_DEF(D, 6), FASTPIN_DEF(D, 7),   // D4-D7
+  FASTPIN_DEF(B, 0), FASTPIN_DEF(B, 1), FASTPIN_DEF(B, 2), FASTPIN_DEF(B, 3),   // D8-D11
+  FASTPIN_DEF(B, 4), FASTPIN_DEF(B, 5),                                         // D12-D13
+  FASTPIN_DEF(C, 0), FASTPIN_DEF(C, 1), FASTPIN_DEF(C, 2), FASTPIN_DEF(C, 3),   // A0-A3
+  FASTPIN_DEF(C, 4), FASTPIN_DEF(C, 5)                                          // A4-A5
+};
+#endif
+
+constexpr uint8_t fastPinPort(uint8_t pin) {
+  return (pin < sizeof(FASTPIN_MAP)) ? (uint8_t)(FASTPIN_MAP[pin] >> 3) : (uint8_t)FASTPORT_NONE;
+}
+
+constexpr uint8_t fastPinMask(uint8_t pin) {
+  return (pin < sizeof(FASTPIN_MAP)) ? (uint8_t)(1 << (FASTPIN_MAP[pin] & 0x07)) : (uint8_t)0;
+}
+
+// Com argumento constante o switch inteiro some na compilação (-Os)
+__attribute__((always_inline)) inline volatile uint8_t& fastPortRegister(uint8_t port) {
+  switch (port) {
+#ifdef PORTA
+    case FASTPORT_A: return PORTA;
+#endif
+#ifdef PORTC
+    case FASTPORT_C: return PORTC;
+#endif
+#ifdef PORTD
+    case FASTPORT_D: return PORTD;
+#endif
+#ifdef PORTE
+    case FASTPORT_E: return PORTE;
+#endif
+#ifdef PORTF
+    case FASTPORT_F: return PORTF;
+#endif
+#ifdef PORTG
+    case FASTPORT_G: return PORTG;
+#endif
+#ifdef PORTH
+    case FASTPORT_H: return PORTH;
+#endif
+#ifdef PORTJ
+    case FASTPORT_J: return PORTJ;
+#endif
+#ifdef PORTK
+    case FASTPORT_K: return PORTK;
+#endif
+#ifdef PORTL
+    case FASTPORT_L: return PORTL;
+#endif
+    default: return PORTB;  // FASTPORT_B (pinos inválidos param no static_assert)
+  }
+}
+
+// ============================================================================
+// FASTPIN
+// ============================================================================
+
+/**
+ * @brief Pino digital com PORTx e máscara resolvidos em compilação
+ *
+ * Nas portas A-G o |=/&= vira sbi/cbi, que é atômico. No Mega, as portas
+ * H, J, K e L ficam no I/O estendido e o compilador gera ld/or/st: só é
+ * seguro chamar com interrupções desabilitadas (dentro de ISR ou de um
+ * bloco noInterrupts()), como já fazem as funções do scheduler.
+ */
+template <uint8_t PIN>
+struct FastPin {
+  static constexpr uint8_t port = fastPinPort(PIN);
+  static constexpr uint8_t mask = fastPinMask(PIN);
+  static_assert(port != FASTPORT_NONE, "Pino sem PORTx conhecido em fastpin.h");
+
+  __attribute__((always_inline)) static inline void high() {
+    fastPortRegister(port) |= mask;
+  }
+
+  __attribute__((always_inline)) static inline void low() {
+    fastPortRegister(port) &= (uint8_t)~mask;
+  }
+
+  __attribute__((always_inline)) static inline void write(bool level) {
+    if (level) {
+      high();
+    } else {
+      low();
+    }
+  }
+
+  // PINx fica dois endereços antes do PORTx em todas as portas do AVR
+  __attribute__((always_inline)) static inline bool read() {
+    return (*(&fastPortRegister(port) - 2) & mask) != 0;
+  }
+};
+
+#endif // FASTPIN_H
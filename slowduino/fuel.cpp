@@ -12,6 +12,57 @@
 static uint8_t aseCounter = 0;       // Contador de ignições restantes com ASE
 static uint8_t aseValue = 100;       // Valor atual de ASE (%)
 
+// ============================================================================
+// PONTO FIXO
+// ============================================================================
+// O PW é um produto de razões (VE/100, MAP/1000, correções/100). Dividir por
+// 100 ou 1000 a cada passo custa ~600 ciclos por divisão de 32 bits no AVR;
+// em vez disso cada razão vira ponto fixo binário multiplicando por uma
+// constante 2^n / 10^k, e os produtos ficam com a metade alta de 32x32 bits.
+
+// Produto das quatro correções multiplicativas (%^4): 1% = 10^6
+#define CORR_PCT_UNIT     1000000UL
+
+#define FUEL_LOAD_SHIFT   12            // VE * MAPx10 (< 2^20) << 12 cabe em 32 bits
+#define FUEL_LOAD_K       175921860UL   // 2^44 / 10^5 -> VE/100 * MAP/1000 em Q24
+#define FUEL_CORR_SHIFT   4             // Produto limitado (< 2^28) << 4
+#define FUEL_CORR_K       1441151881UL  // 2^57 / 10^8 -> correções/100 em Q29
+#define FUEL_PW_SHIFT     11            // reqFuel << 11 * Q21 / 2^32 = us
+#define FUEL_PCT_K        4295UL        // ~2^32 / 10^6 -> % inteiro (só exibição)
+
+/**
+ * @brief floor(a * b / 2^32) sem aritmética de 64 bits
+ *
+ * Quatro multiplicações 16x16 (MUL em hardware); o resultado é exato.
+ */
+static inline uint32_t mulHigh32(uint32_t a, uint32_t b) {
+  uint16_t al = (uint16_t)a, ah = (uint16_t)(a >> 16);
+  uint16_t bl = (uint16_t)b, bh = (uint16_t)(b >> 16);
+
+  uint32_t ll = (uint32_t)al * bl;
+  uint32_t lh = (uint32_t)al * bh;
+  uint32_t hl = (uint32_t)ah * bl;
+  uint32_t hh = (uint32_t)ah * bh;
+
+  // Soma das partes do meio: no máximo 3 * 0xFFFF, não estoura
+  uint32_t mid = (ll >> 16) + (uint16_t)lh + (uint16_t)hl;
+  return hh + (lh >> 16) + (hl >> 16) + (mid >> 16);
+}
+
+// Cache do produto WUE * ASE * CLT * bateria. As entradas mudam a 4Hz (CLT,
+// bateria) ou a cada passo do ASE, não a cada passada do loop - o produto
+// (e a interpolação do WUE, que divide) só é refeito quando uma delas muda.
+static uint32_t corrProduct = 0;
+static int8_t corrCoolant = 0;
+static uint8_t corrBattery = 0;
+static uint8_t corrASE = 0;
+static uint8_t corrWarmup = 0;
+static bool corrValid = false;
+
+void fuelApplyConfig() {
+  corrValid = false;
+}
+
 // ============================================================================
 // CÁLCULO PRINCIPAL DE INJEÇÃO
 // ============================================================================
@@ -21,19 +72,17 @@ uint16_t calculateInjection() {
   uint8_t ve = getVE();
   currentStatus.VE = ve;
 
-  // 2. Calcula correções
-  uint16_t corrections = calculateCorrections();
-  currentStatus.corrections = corrections;
+  // 2. Calcula correções (razão em Q29)
+  uint32_t corrections = calculateCorrections();
 
   // 3. Calcula PW base
-  // PW = (reqFuel * VE / 100) * (MAP / 100) * (corrections / 100)
-  // Simplificando para evitar overflow:
-  // PW = (reqFuel * VE * MAP * corrections) / (100 * 100 * 100)
-
-  uint32_t pw = (uint32_t)configPage1.reqFuel;
-  pw = (pw * ve) / 100;
-  pw = (pw * currentStatus.MAP) / 100;
-  pw = (pw * corrections) / 100;
+  // PW = reqFuel * (VE / 100) * (MAP / 1000) * (corrections / 100)
+  // VE * MAPx10 é exato em 32 bits; vira razão Q24, multiplica as correções
+  // (Q29 -> Q21) e por fim o reqFuel (Q21 -> us). Sem divisões e sem os
+  // truncamentos intermediários: o erro fica abaixo de 1us do valor exato.
+  uint32_t load = mulHigh32(((uint32_t)ve * currentStatus.MAPx10) << FUEL_LOAD_SHIFT, FUEL_LOAD_K);
+  uint32_t ratio = mulHigh32(load, corrections);
+  uint32_t pw = mulHigh32((uint32_t)configPage1.reqFuel << FUEL_PW_SHIFT, ratio);
 
   // 4. Adiciona tempo de abertura do injetor (deadtime)
   pw += configPage1.injOpen;
@@ -56,7 +105,7 @@ uint16_t calculateInjection() {
 
 uint8_t getVE() {
   // Usa MAP e RPM para buscar na tabela
-  int16_t ve = getTableValue(&veTable, currentStatus.MAP, currentStatus.RPM);
+  int16_t ve = getTableValue(&veTable, currentStatus.MAP, currentStatus.RPMinstant);
 
   // Garante range válido
   if (ve < 0) ve = 0;
@@ -69,36 +118,47 @@ uint8_t getVE() {
 // CORREÇÕES
 // ============================================================================
 
-uint16_t calculateCorrections() {
-  uint16_t total = 100;  // Base 100%
-
-  // 1. Warm-Up Enrichment (multiplicativo)
-  uint8_t wue = correctionWUE();
-  currentStatus.wueCorrection = wue;
-  total = PERCENT(total, wue);
-
-  // 2. After-Start Enrichment (multiplicativo)
+uint32_t calculateCorrections() {
+  // 1-4. WUE, ASE, CLT e bateria (multiplicativos): produto exato em %^4,
+  // refeito só quando alguma entrada muda
   uint8_t ase = correctionASE();
-  total = PERCENT(total, ase);
-
-  // 3. CLT correction (multiplicativo)
-  uint8_t clt = correctionCLT();
-  total = PERCENT(total, clt);
+  uint8_t warmup = BIT_CHECK(currentStatus.engineStatus, ENGINE_WARMUP) ? 1 : 0;
+
+  if (!corrValid || currentStatus.coolant != corrCoolant ||
+      currentStatus.battery10 != corrBattery || ase != corrASE || warmup != corrWarmup) {
+    uint8_t wue = correctionWUE();
+    currentStatus.wueCorrection = wue;
+
+    uint8_t bat = correctionBattery();
+    currentStatus.batCorrection = bat;
+
+    // Dois produtos de 8x8 bits e um de 16x16: até 255^4 < 2^32
+    uint16_t wueAse = (uint16_t)wue * ase;
+    uint16_t cltBat = (uint16_t)correctionCLT() * bat;
+    corrProduct = (uint32_t)wueAse * cltBat;
+
+    corrCoolant = currentStatus.coolant;
+    corrBattery = currentStatus.battery10;
+    corrASE = ase;
+    corrWarmup = warmup;
+    corrValid = true;
+  }
 
-  // 4. Battery correction (multiplicativo)
-  uint8_t bat = correctionBattery();
-  currentStatus.batCorrection = bat;
-  total = PERCENT(total, bat);
+  // Acima de CORR_MAX o resultado satura de qualquer jeito (o AE só soma);
+  // limitar antes deixa espaço para o AE sem estourar 32 bits
+  uint32_t total = corrProduct;
+  if (total > CORR_MAX * CORR_PCT_UNIT) total = CORR_MAX * CORR_PCT_UNIT;
 
   // 5. Acceleration Enrichment (aditivo)
-  uint8_t ae = correctionAE();
-  total += ae;
+  total += (uint32_t)correctionAE() * CORR_PCT_UNIT;
 
   // Limita resultado
-  if (total < CORR_MIN) total = CORR_MIN;
-  if (total > CORR_MAX) total = CORR_MAX;
+  if (total < CORR_MIN * CORR_PCT_UNIT) total = CORR_MIN * CORR_PCT_UNIT;
+  if (total > CORR_MAX * CORR_PCT_UNIT) total = CORR_MAX * CORR_PCT_UNIT;
+
+  currentStatus.corrections = (uint16_t)mulHigh32(total, FUEL_PCT_K);
 
-  return total;
+  return mulHigh32(total << FUEL_CORR_SHIFT, FUEL_CORR_K);
 }
 
 // ============================================================================
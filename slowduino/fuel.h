@@ -22,6 +22,9 @@
  *
  * Formula base: PW = (reqFuel × VE% × MAP% × corrections) + injectorOpenTime
  *
+ * Calculada em ponto fixo binário, sem divisões; o PW fica a menos de 1us
+ * do valor exato da fórmula.
+ *
  * @return Pulsewidth em microsegundos
  */
 uint16_t calculateInjection();
@@ -37,10 +40,19 @@ uint8_t getVE();
 /**
  * @brief Calcula todas as correções de combustível
  *
- * Multiplica/adiciona correções: WUE, ASE, AE, CLT, Bat, etc
- * @return Fator de correção (base 100)
+ * Multiplica/adiciona correções: WUE, ASE, AE, CLT, Bat, etc. Também
+ * atualiza currentStatus.corrections (% inteiro, para exibição).
+ *
+ * @return Fator de correção em Q29 (1.0 = 100% = 2^29)
+ */
+uint32_t calculateCorrections();
+
+/**
+ * @brief Invalida o cache das correções multiplicativas
+ *
+ * Chamar sempre que a página 1 (tabela WUE) for alterada pelo TunerStudio.
  */
-uint16_t calculateCorrections();
+void fuelApplyConfig();
 
 // ============================================================================
 // CORREÇÕES INDIVIDUAIS
@@ -41,11 +41,14 @@
 struct Statuses {
   // Motor
   uint16_t RPM;                // Rotações por minuto
+  int16_t  rpmDOT;             // Aceleração angular (RPM/s, pelos últimos dentes)
+  uint16_t RPMinstant;         // RPM dos últimos dentes: eixo das tabelas VE e avanço
   // RPMdiv100 removido - escrito em 5 lugares (decoders.cpp), nunca lido
   // em lugar nenhum (achado por varredura de campos mortos)
   bool hasSync;                // Motor sincronizado com trigger
 
-  // Sensores analógicos (valores brutos ADC 0-1023)
+  // Sensores analógicos (valores brutos ADC 0-1023; MAP e TPS em 12 bits,
+  // 0-4095, pela sobreamostragem - ADC_EXTRA_BITS_MAP/TPS)
   uint16_t mapADC;
   uint16_t tpsADC;
   uint16_t cltADC;
@@ -56,8 +59,10 @@ struct Statuses {
   uint16_t fuelPressADC;
 
   // Sensores convertidos (valores físicos)
-  uint8_t  MAP;                // Pressão kPa (0-255)
+  uint8_t  MAP;                // Pressão kPa (0-255), eixo das tabelas
+  uint16_t MAPx10;             // Pressão kPa * 10 (100-2550), para o PW
   uint8_t  TPS;                // Posição borboleta % (0-100)
+  uint8_t  TPSx2;              // Posição borboleta em 0,5% (0-200)
   int8_t   coolant;            // Temperatura motor °C (-40 a +215)
   int8_t   IAT;                // Temperatura ar °C (-40 a +215)
   uint8_t  O2;                 // Lambda % (0-255, 100 = lambda 1.0)
@@ -103,7 +108,7 @@ struct Statuses {
 
   // TPS rate of change
   int16_t  TPSdot;             // Taxa de mudança TPS (%/s)
-  uint8_t  TPSlast;            // TPS anterior
+  uint8_t  TPSx2last;          // TPSx2 anterior (0,5%)
 
   // loopCount removido (0 usos em todo o projeto) e ignitionCount removido
   // (só incrementado em scheduler.cpp, nunca lido)
@@ -165,6 +170,19 @@ struct ConfigPage1 {
   uint8_t  oilPressureProtHysteresis; // Histeresis
   uint8_t  oilPressureProtDelay;      // Delay ticks
 
+  // Injeção sequencial (precisa do sensor de fase - configPage2.camInput)
+  uint8_t  injectorLayout;     // INJ_LAYOUT_PAIRED ou INJ_LAYOUT_SEQUENTIAL
+  uint16_t injEndAngle;        // Fim da injeção, graus antes do PMS de compressão (0-719)
+
+  // Amostragem do MAP
+  uint8_t  mapSample;          // MAP_SAMPLE_INSTANT, _AVERAGE ou _MINIMUM
+
+  // Calibração dos termistores: °C + 40 a cada 32 contagens do ADC
+  // (CALIBRATION_POINTS). Curva toda igual (EEPROM antiga, zerada) é
+  // trocada pela curva NTC padrão no boot.
+  uint8_t  cltCalibration[33];
+  uint8_t  iatCalibration[33];
+
   // Reserva para compatibilidade com Speeduino (página 1 = 128 bytes).
   // Cresceu de 76 para 94 bytes: removidos injectorLayout, divider,
   // mapSample, aeTime, stoich e o cluster egoType..egoHysteresis (13
@@ -173,7 +191,11 @@ struct ConfigPage1 {
   // nenhuma linha de código implementada em fuel.cpp/sensors.cpp, apesar
   // do que docs/specifications.md descreve). Ficam reservados aqui em vez
   // de reaproveitados por outro campo, preservando os 128 bytes da página.
-  uint8_t  spare[94];
+  // injectorLayout/injEndAngle saíram daqui (3 bytes): EEPROM antiga lê 0,
+  // que é layout pareado. mapSample também (1 byte): 0 é o instantâneo,
+  // o comportamento de antes. cltCalibration/iatCalibration (66 bytes)
+  // idem - ver loadCalibrationTables().
+  uint8_t  spare[24];
 
 } __attribute__((packed));
 
@@ -254,11 +276,21 @@ struct ConfigPage2 {
   uint8_t  idleAdvBins[4];     // Delta de RPM (alvo - atual) / 10
   int8_t   idleAdvValues[4];   // Avanço adicional (graus, pode ser negativo)
 
+  // Sensor de fase no comando (INT1 - PIN_TRIGGER_SECONDARY)
+  uint8_t  camInput;           // CAM_INPUT_OFF ou CAM_INPUT_SINGLE
+  uint8_t  camEdge;            // 0=Rising, 1=Falling
+
+  // Calibração da sonda O2: valor de currentStatus.O2 a cada 32 contagens do
+  // ADC (CALIBRATION_POINTS). Padrão = ADC / 4, a conversão de antes.
+  uint8_t  o2Calibration[33];
+
   // Reserva para compatibilidade com Speeduino (página 4 = 128 bytes).
   // Cresceu de 60 para 64 bytes: removidos triggerAngle, idleAdvance,
   // idleRPM e engineProtectCutType (4 campos mortos - ver comentários
-  // acima), preservando os 128 bytes da página.
-  uint8_t  spare[64];
+  // acima), preservando os 128 bytes da página. camInput/camEdge saíram
+  // daqui (2 bytes): EEPROM antiga lê 0, que é sensor de fase desligado.
+  // o2Calibration saiu daqui (33 bytes).
+  uint8_t  spare[29];
 
 } __attribute__((packed));
 
@@ -280,9 +312,6 @@ static_assert(sizeof(ConfigPage2) == 128, "ConfigPage2 deve ocupar 128 bytes");
 // Conversão rápida de ADC 10-bit para 8-bit
 #define ADC_10_TO_8(x)  ((x) >> 2)
 
-// Percentual (evita overflow em multiplicação)
-#define PERCENT(val, pct) (((uint32_t)(val) * (pct)) / 100)
-
 // Protections
 #define PROTECTION_RPM_BIT 0x01
 #define PROTECTION_OIL_BIT 0x02
@@ -290,8 +319,9 @@ static_assert(sizeof(ConfigPage2) == 128, "ConfigPage2 deve ocupar 128 bytes");
 // (bloco estava duplicado; as macros não tinham mais nenhum uso)
 
 // Map rápido (assumindo range específico)
+// Produto em 32 bits: no AVR o int tem 16 bits, e 1023 * 245 (MAP) já estourava
 inline uint16_t fastMap(uint16_t x, uint16_t in_min, uint16_t in_max, uint16_t out_min, uint16_t out_max) {
-  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+  return (uint32_t)(x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
 
 #endif // GLOBALS_H
@@ -37,7 +37,7 @@ int8_t calculateAdvance() {
 
 int8_t getBaseAdvance() {
   // Busca na tabela de ignição (MAP vs RPM)
-  int16_t advance = getTableValue(&ignTable, currentStatus.MAP, currentStatus.RPM);
+  int16_t advance = getTableValue(&ignTable, currentStatus.MAP, currentStatus.RPMinstant);
 
   // Tabela de ignição usa int8_t (graus, pode ser negativo)
   return (int8_t)advance;
@@ -7,12 +7,31 @@
 
 static const uint16_t IGNITION_MIN_DELAY_US = 25;  // Proteção contra eventos já vencidos
 
+// Maior distância (em ticks do hardware) armada num compare. Eventos mais
+// distantes que uma volta do TCNT1 (ex: cranking no prescaler 8) armam um
+// "despertador" intermediário e a ISR reavalia ao disparar.
+static const uint16_t SCHED_MAX_ARM_TICKS = 0xFF00;
+
 // Instancia schedules globais
-volatile FuelSchedule fuelSchedule1 = {SCHED_OFF, 0, 0, 0, 1};
-volatile FuelSchedule fuelSchedule2 = {SCHED_OFF, 0, 0, 0, 2};
-volatile FuelSchedule fuelSchedule3 = {SCHED_OFF, 0, 0, 0, 3};
-volatile IgnitionSchedule ignitionSchedule1 = {SCHED_OFF, 0, 0, 0, 1};
-volatile IgnitionSchedule ignitionSchedule2 = {SCHED_OFF, 0, 0, 0, 2};
+volatile FuelSchedule fuelSchedule1 = {SCHED_OFF, 0, 0, 1};
+volatile FuelSchedule fuelSchedule2 = {SCHED_OFF, 0, 0, 2};
+volatile FuelSchedule fuelSchedule3 = {SCHED_OFF, 0, 0, 3};
+volatile IgnitionSchedule ignitionSchedule1 = {SCHED_OFF, 0, 0, 1};
+volatile IgnitionSchedule ignitionSchedule2 = {SCHED_OFF, 0, 0, 2};
+
+volatile bool coilChargeLevel = true;
+
+// Escala ativa do Timer1: quantos bits deslocar o TCNT1 para ticks finos
+volatile uint8_t timer1TickShift = TIMER1_SHIFT_COARSE;
+
+// Microsegundos correspondentes a TCNT1 = 0 na volta atual do contador
+static volatile uint32_t timer1MicrosBase = 0;
+
+// Fila de eventos ordenada por tempo (eventQueue[0] = próximo a vencer).
+// Só é acessada dentro das ISRs do Timer1/trigger ou com interrupções
+// desabilitadas, por isso não precisa de volatile.
+static ScheduleEvent eventQueue[SCHED_QUEUE_SIZE];
+static uint8_t eventCount = 0;
 
 // ============================================================================
 // INICIALIZAÇÃO
@@ -26,12 +45,18 @@ void schedulerInit() {
   pinMode(PIN_IGNITION_1, OUTPUT);
   pinMode(PIN_IGNITION_2, OUTPUT);
 
-  // Garante que tudo está desligado
+  // Polaridade das bobinas antes de desligá-las
+  schedulerApplyConfig();
+
+  // Garante que tudo está desligado. FastPin no I/O estendido do Mega não é
+  // atômico - protege contra a ISR do Timer2 mexendo na mesma porta.
+  noInterrupts();
   closeInjector1();
   closeInjector2();
   closeInjector3();
   endCoil1Charge();
   endCoil2Charge();
+  interrupts();
 
   // Configura Timer1
   setupTimer1();
@@ -48,53 +73,309 @@ void setupTimer1() {
   // Modo Normal (contagem livre até overflow 0xFFFF)
   // WGM13:0 = 0000 → nenhum reset no compare, permite usar OCR1A/B como agendadores absolutos
 
-  // Prescaler = 256
+  // Começa com prescaler 256 (motor parado / cranking)
   // CS12:0 = 100
-  // 16MHz / 256 = 62.5kHz -> 16us por tick (cobre cranking lento)
+  // 16MHz / 256 = 62.5kHz -> 16us por tick
+  // schedulerUpdateResolution() troca para prescaler 8 (0,5us) em alta rotação
+  timer1TickShift = TIMER1_SHIFT_COARSE;
+  timer1MicrosBase = 0;
   TCCR1B |= (1 << CS12);
 
-  // Valor inicial alto evita interrupção imediata antes do primeiro agendamento
-  OCR1A = 0xFFFF;
+  // Overflow mantém o relógio estendido de 32 bits
+  TIFR1 = (1 << TOV1);
+  TIMSK1 |= (1 << TOIE1);
+
+  // Fila vazia: compares desarmados até o primeiro agendamento
+  eventCount = 0;
+  TIMSK1 &= ~((1 << OCIE1A) | (1 << OCIE1B));
+}
+
+void schedulerApplyConfig() {
+  bool level = (configPage2.ignInvert == 0);  // Normal: HIGH carrega a bobina
+
+  if (level == coilChargeLevel) return;
+
+  // Polaridade mudou com o motor girando: desliga as bobinas no nível novo
+  // e descarta o que estava agendado, senão uma bobina ficaria carregando
+  // indefinidamente (o "fim" da carga passaria a ser o nível de carga).
+  uint8_t oldSREG = SREG;
+  cli();
+  coilChargeLevel = level;
+  clearIgnitionSchedule(&ignitionSchedule1);
+  clearIgnitionSchedule(&ignitionSchedule2);
+  SREG = oldSREG;
+}
+
+// ============================================================================
+// RELÓGIO ESTENDIDO DO TIMER1
+// ============================================================================
+// Uma única base de tempo para o firmware inteiro: TCNT1 deslocado pela escala
+// ativa + voltas contadas na ISR de overflow. A mesma leitura vira
+// microsegundos (timer1Micros(), usado pelos decoders) ou "ticks finos" de
+// 0,5us (resolução do prescaler 8, usados pela fila). Assim os eventos não
+// mudam de unidade quando o prescaler troca, e nenhum evento fica limitado a
+// meia volta do TCNT1. Os ticks finos são sempre 2x os microsegundos (módulo
+// 2^32); as comparações usam diferença com cast para int32_t.
+
+// Microsegundos de uma volta completa do TCNT1 na escala ativa
+#define TIMER1_TURN_US  ((0x10000UL << timer1TickShift) >> 1)
+
+// Chamar com interrupções desabilitadas. Devolve a base (us) da volta em que
+// o TCNT1 lido (count) está.
+static inline uint32_t readTimer1Base(uint16_t& count) {
+  count = TCNT1;
+  uint32_t base = timer1MicrosBase;
+
+  // Overflow que aconteceu antes da leitura mas ainda não foi tratado pela
+  // ISR (interrupções desligadas): TOV1 ligado com TCNT1 já no início da volta
+  if ((TIFR1 & (1 << TOV1)) && count < 0x8000) {
+    base += TIMER1_TURN_US;
+  }
+
+  return base;
+}
+
+// Chamar com interrupções desabilitadas. Devolve também o TCNT1 lido.
+static inline uint32_t readTimer1Ticks(uint16_t& count) {
+  uint32_t base = readTimer1Base(count);
+  return (base << 1) + ((uint32_t)count << timer1TickShift);
+}
+
+uint32_t timer1Micros() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t count;
+  uint32_t base = readTimer1Base(count);
+  uint8_t shift = timer1TickShift;
+  SREG = oldSREG;
+
+  return base + (((uint32_t)count << shift) >> 1);
+}
+
+uint32_t timer1CaptureMicros(uint16_t capture) {
+  uint16_t count;
+  uint32_t base = readTimer1Base(count);
 
-  // Habilita interrupções de Compare Match para Channels A, B
-  TIMSK1 |= (1 << OCIE1A);  // Compare Match A (usaremos para fuel/ign 1)
-  TIMSK1 |= (1 << OCIE1B);  // Compare Match B (usaremos para fuel/ign 2)
+  // Captura feita antes do TCNT1 dar a volta, lida depois: pertence à volta
+  // anterior. A latência da ISR é sempre bem menor que uma volta (32ms).
+  if (capture > count) {
+    base -= TIMER1_TURN_US;
+  }
+
+  return base + (((uint32_t)capture << timer1TickShift) >> 1);
+}
+
+// ============================================================================
+// FILA DE EVENTOS
+// ============================================================================
+
+// Executa a ação de um evento vencido e atualiza o status do schedule dono
+static void fireEvent(uint8_t action) {
+  switch (action) {
+    case EVT_INJ1_OPEN:   openInjector1();   fuelSchedule1.status = SCHED_RUNNING; break;
+    case EVT_INJ1_CLOSE:  closeInjector1();  fuelSchedule1.status = SCHED_OFF;     break;
+    case EVT_INJ2_OPEN:   openInjector2();   fuelSchedule2.status = SCHED_RUNNING; break;
+    case EVT_INJ2_CLOSE:  closeInjector2();  fuelSchedule2.status = SCHED_OFF;     break;
+    case EVT_INJ3_OPEN:   openInjector3();   fuelSchedule3.status = SCHED_RUNNING; break;
+    case EVT_INJ3_CLOSE:  closeInjector3();  fuelSchedule3.status = SCHED_OFF;     break;
+    case EVT_IGN1_CHARGE: beginCoil1Charge(); ignitionSchedule1.status = SCHED_RUNNING; break;
+    case EVT_IGN1_SPARK:  endCoil1Charge();   ignitionSchedule1.status = SCHED_OFF;     break;
+    case EVT_IGN2_CHARGE: beginCoil2Charge(); ignitionSchedule2.status = SCHED_RUNNING; break;
+    case EVT_IGN2_SPARK:  endCoil2Charge();   ignitionSchedule2.status = SCHED_OFF;     break;
+  }
+}
+
+// Insere mantendo a fila ordenada pelo tempo absoluto
+static void queueInsert(uint32_t tick, uint8_t action) {
+  if (eventCount >= SCHED_QUEUE_SIZE) return;  // Não acontece: 2 eventos por canal
+
+  uint8_t i = eventCount;
+  while (i > 0 && (int32_t)(tick - eventQueue[i - 1].tick) < 0) {
+    eventQueue[i] = eventQueue[i - 1];
+    i--;
+  }
+  eventQueue[i].tick = tick;
+  eventQueue[i].action = action;
+  eventCount++;
+}
+
+// Remove os eventos pendentes das duas ações de um schedule (início e fim)
+static void queueRemove(uint8_t startAction) {
+  uint8_t out = 0;
+  for (uint8_t i = 0; i < eventCount; i++) {
+    uint8_t action = eventQueue[i].action;
+    if (action != startAction && action != (uint8_t)(startAction + 1)) {
+      eventQueue[out++] = eventQueue[i];
+    }
+  }
+  eventCount = out;
+}
+
+// Move um evento que ainda está na fila para outro tick. Devolve false se
+// ele já venceu (não está mais na fila).
+static bool queueMove(uint8_t action, uint32_t tick) {
+  for (uint8_t i = 0; i < eventCount; i++) {
+    if (eventQueue[i].action == action) {
+      eventCount--;
+      for (uint8_t j = i; j < eventCount; j++) {
+        eventQueue[j] = eventQueue[j + 1];
+      }
+      queueInsert(tick, action);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Valor de compare (TCNT1) para um evento, limitado a SCHED_MAX_ARM_TICKS
+static inline uint16_t compareFor(uint32_t tick, uint32_t now, uint16_t count) {
+  uint32_t hwTicks = (tick - now) >> timer1TickShift;
+  if (hwTicks == 0) hwTicks = 1;
+  if (hwTicks > SCHED_MAX_ARM_TICKS) hwTicks = SCHED_MAX_ARM_TICKS;
+  return count + (uint16_t)hwTicks;
+}
+
+// Dispara tudo que já venceu e arma OCR1A/OCR1B com os dois próximos eventos.
+// Timer1 roda em modo Normal (free-running, não reseta no compare match).
+// Entre decidir o próximo evento e escrever OCR1x, TCNT1 pode já ter avançado
+// além do alvo (ex: interrupções atrasadas). Se isso acontecer, o compare
+// match só dispararia na próxima volta do contador de 16 bits, perdendo o
+// evento. Detecta a corrida após armar e processa na hora.
+static void serviceQueue() {
+  uint16_t count;
+  uint32_t now = readTimer1Ticks(count);
+
+  while (eventCount > 0) {
+    if ((int32_t)(now - eventQueue[0].tick) >= 0) {
+      uint8_t action = eventQueue[0].action;
+      eventCount--;
+      for (uint8_t i = 0; i < eventCount; i++) {
+        eventQueue[i] = eventQueue[i + 1];
+      }
+      fireEvent(action);
+      continue;
+    }
+
+    OCR1A = compareFor(eventQueue[0].tick, now, count);
+    uint8_t mask = (1 << OCIE1A);
+    if (eventCount > 1) {
+      OCR1B = compareFor(eventQueue[1].tick, now, count);
+      mask |= (1 << OCIE1B);
+    }
+    // Flags antigas (de compares já consumidos) gerariam ISRs vazias
+    TIFR1 = (1 << OCF1A) | (1 << OCF1B);
+    TIMSK1 = (TIMSK1 & ~((1 << OCIE1A) | (1 << OCIE1B))) | mask;
+
+    // Relê o relógio: se o compare de OCR1A já passou, processa na hora
+    uint16_t armedCompare = OCR1A;
+    uint16_t armedFrom = count;
+    now = readTimer1Ticks(count);
+    if ((uint16_t)(count - armedFrom) < (uint16_t)(armedCompare - armedFrom)) {
+      return;  // Armado a tempo
+    }
+  }
+
+  // Nada pendente
+  TIMSK1 &= ~((1 << OCIE1A) | (1 << OCIE1B));
+}
+
+// Converte atraso (us) em tick absoluto da fila (nunca no passado)
+static inline uint32_t delayToTick(uint32_t delayUs, uint32_t now) {
+  if (delayUs == 0) delayUs = 1;
+  return now + US_TO_SCHED_TICKS(delayUs);
+}
+
+// ============================================================================
+// RESOLUÇÃO DO TIMER1
+// ============================================================================
+
+void schedulerUpdateResolution(uint32_t revolutionTime) {
+  uint8_t shift = timer1TickShift;
+
+  // Histerese entre as duas faixas para não ficar trocando perto do limite
+  if (shift == TIMER1_SHIFT_COARSE) {
+    if (revolutionTime != 0 && revolutionTime < TIMER1_FINE_ENTER_US) {
+      shift = TIMER1_SHIFT_FINE;
+    }
+  } else if (revolutionTime == 0 || revolutionTime > TIMER1_FINE_EXIT_US) {
+    shift = TIMER1_SHIFT_COARSE;
+  }
+
+  if (shift == timer1TickShift) return;
+
+  uint8_t oldSREG = SREG;
+  cli();
+
+  // Para o contador. ICNC1/ICES1 (input capture do trigger) ficam no mesmo
+  // registrador e são preservados.
+  uint8_t clockBits = TCCR1B & ((1 << CS12) | (1 << CS11) | (1 << CS10));
+  TCCR1B &= ~((1 << CS12) | (1 << CS11) | (1 << CS10));
+
+  // Captura do trigger ainda não consumida: o ICR1 está na escala antiga e
+  // viraria lixo depois da troca. Adia para a próxima chamada (15Hz).
+  if (TIFR1 & (1 << ICF1)) {
+    TCCR1B |= clockBits;
+    SREG = oldSREG;
+    return;
+  }
+
+  // Congela o relógio estendido no instante da troca e recomeça o TCNT1 do
+  // zero na escala nova. Os eventos da fila estão em ticks finos absolutos,
+  // então nenhum deles muda; só os compares são rearmados. O erro da troca é
+  // a fração de tick do prescaler antigo que se perde (no máximo 16us, uma
+  // única vez).
+  uint32_t now = timer1Micros();
+
+  TCNT1 = 0;
+  TIFR1 = (1 << TOV1);
+  timer1MicrosBase = now;
+  timer1TickShift = shift;
+  TCCR1B |= (shift == TIMER1_SHIFT_FINE) ? (1 << CS11) : (1 << CS12);
+
+  serviceQueue();
+
+  SREG = oldSREG;
 }
 
 // ============================================================================
 // AGENDAMENTO DE INJEÇÃO
 // ============================================================================
 
-void setFuelSchedule(volatile FuelSchedule* schedule, uint16_t startTime, uint16_t duration, uint8_t channel) {
+void setFuelSchedule(volatile FuelSchedule* schedule, uint32_t startTime, uint16_t duration, uint8_t channel) {
+  if (channel == 0 || channel > BOARD_INJ_CHANNELS) return;
+
+  uint8_t oldSREG = SREG;
+  cli();
+
   // Proteção: Não agendar se schedule anterior ainda está RUNNING
   if (schedule->status == SCHED_RUNNING) {
     // Cancela schedule anterior
     clearFuelSchedule(schedule);
   }
 
-  // Converte microsegundos para ticks do timer (× 2)
-  uint16_t startTicks = US_TO_TIMER1(startTime);
-  uint16_t durationTicks = US_TO_TIMER1(duration);
+  uint8_t openAction = EVT_INJ1_OPEN + 2 * (channel - 1);
+  queueRemove(openAction);
 
-  // Calcula valores de compare
-  uint16_t currentCount = TCNT1;
-  schedule->startCompare = currentCount + startTicks;
-  schedule->endCompare = schedule->startCompare + durationTicks;
-  schedule->duration = durationTicks;
+  // Calcula tempos absolutos
+  uint16_t count;
+  uint32_t now = readTimer1Ticks(count);
+
+  schedule->startTick = delayToTick(startTime, now);
+  schedule->endTick = schedule->startTick + US_TO_SCHED_TICKS(duration);
   schedule->channel = channel;
   schedule->status = SCHED_PENDING;
 
-  // Configura compare register apropriado
-  if (channel == 1 || channel == 3) {
-    // Canais 1 e 3 compartilham OCR1A
-    OCR1A = schedule->startCompare;
-  } else {
-    // Canal 2 usa OCR1B
-    OCR1B = schedule->startCompare;
-  }
+  queueInsert(schedule->startTick, openAction);
+  queueInsert(schedule->endTick, openAction + 1);
+  serviceQueue();
+
+  SREG = oldSREG;
 }
 
 void clearFuelSchedule(volatile FuelSchedule* schedule) {
+  uint8_t oldSREG = SREG;
+  cli();
+
   schedule->status = SCHED_OFF;
 
   // Fecha injetor se estava aberto
@@ -105,44 +386,13 @@ void clearFuelSchedule(volatile FuelSchedule* schedule) {
   } else if (schedule->channel == 3) {
     closeInjector3();
   }
-}
-
-// ============================================================================
-// HELPERS PARA ISRs DE IGNIÇÃO
-// ============================================================================
 
-static inline void handleIgnitionChannel(volatile IgnitionSchedule* schedule,
-                                         void (*beginCharge)(),
-                                         void (*endCharge)(),
-                                         volatile uint16_t* compareReg) {
-  if (schedule->status == SCHED_PENDING) {
-    schedule->status = SCHED_RUNNING;
-    beginCharge();
-    *compareReg = schedule->endCompare;
-    return;
+  if (schedule->channel >= 1 && schedule->channel <= BOARD_INJ_CHANNELS) {
+    queueRemove(EVT_INJ1_OPEN + 2 * (schedule->channel - 1));
+    serviceQueue();
   }
 
-  if (schedule->status == SCHED_RUNNING) {
-    schedule->status = SCHED_OFF;
-    endCharge();
-  }
-}
-
-// Timer1 roda em modo Normal (free-running, não reseta no compare match).
-// Entre calcular startCompare e escrever OCR1x, TCNT1 pode já ter avançado
-// além do alvo (ex: interrupções atrasadas). Se isso acontecer, o compare
-// match só dispararia ~1s depois, na próxima volta do contador de 16 bits,
-// perdendo o evento de ignição. Detecta a corrida e processa na hora.
-static inline void armIgnitionCompare(volatile IgnitionSchedule* schedule,
-                                      void (*beginCharge)(),
-                                      void (*endCharge)(),
-                                      volatile uint16_t* compareReg) {
-  *compareReg = schedule->startCompare;
-
-  // Cast para int16_t faz a subtração respeitar o wraparound do contador
-  if ((int16_t)(TCNT1 - schedule->startCompare) >= 0) {
-    handleIgnitionChannel(schedule, beginCharge, endCharge, compareReg);
-  }
+  SREG = oldSREG;
 }
 
 // ============================================================================
@@ -150,61 +400,92 @@ static inline void armIgnitionCompare(volatile IgnitionSchedule* schedule,
 // ============================================================================
 
 void setIgnitionSchedule(volatile IgnitionSchedule* schedule, uint32_t startTime, uint16_t duration, uint8_t channel) {
-  if (channel > BOARD_IGN_CHANNELS) {
+  if (channel == 0 || channel > BOARD_IGN_CHANNELS) {
     schedule->status = SCHED_OFF;
     return;
   }
 
+  uint8_t oldSREG = SREG;
+  cli();
+
   // Proteção: Não agendar se schedule anterior ainda está RUNNING
   if (schedule->status == SCHED_RUNNING) {
     // Cancela schedule anterior
     clearIgnitionSchedule(schedule);
   }
 
+  uint8_t chargeAction = EVT_IGN1_CHARGE + 2 * (channel - 1);
+  queueRemove(chargeAction);
+
   if (startTime < IGNITION_MIN_DELAY_US) {
     schedule->status = SCHED_OFF;
+    serviceQueue();
+    SREG = oldSREG;
     return;
   }
 
-  uint32_t startTicks = US_TO_TIMER1(startTime);
-  uint32_t durationTicks = US_TO_TIMER1(duration);
-  if (durationTicks == 0) {
-    durationTicks = 1;  // Garante pelo menos 1 tick
+  if (duration == 0) {
+    duration = 1;  // Garante pelo menos 1us de dwell
   }
 
-  uint32_t totalTicks = startTicks + durationTicks;
-  uint32_t minTicks = US_TO_TIMER1(IGNITION_MIN_DELAY_US);
+  uint16_t count;
+  uint32_t now = readTimer1Ticks(count);
+  schedule->startTick = delayToTick(startTime, now);
+  schedule->endTick = schedule->startTick + US_TO_SCHED_TICKS(duration);
+  schedule->channel = channel;
 
-  if (startTicks < minTicks) {
-    startTicks = minTicks;
-    if (totalTicks > startTicks) {
-      durationTicks = totalTicks - startTicks;
-    } else {
-      durationTicks = 1;  // Sem janela suficiente → pulso mínimo
-    }
-  }
+  schedule->status = SCHED_PENDING;
 
-  uint16_t currentCount = TCNT1;
-  uint16_t startTicks16 = (uint16_t)startTicks;
-  uint16_t durationTicks16 = (uint16_t)durationTicks;
+  queueInsert(schedule->startTick, chargeAction);
+  queueInsert(schedule->endTick, chargeAction + 1);
+  serviceQueue();
 
-  schedule->startCompare = currentCount + startTicks16;
-  schedule->endCompare = schedule->startCompare + durationTicks16;
-  schedule->duration = durationTicks16;
-  schedule->channel = channel;
+  SREG = oldSREG;
+}
 
-  schedule->status = SCHED_PENDING;
+void retimeIgnitionCharge(volatile IgnitionSchedule* schedule, uint32_t chargeTime) {
+  uint8_t channel = schedule->channel;
+  if (channel == 0 || channel > BOARD_IGN_CHANNELS) return;
+
+  uint8_t oldSREG = SREG;
+  cli();
 
-  if (channel == 1) {
-    // Canal 1 usa OCR1A
-    armIgnitionCompare(schedule, beginCoil1Charge, endCoil1Charge, &OCR1A);
-  } else {
-    // Canal 2 usa OCR1B
-    armIgnitionCompare(schedule, beginCoil2Charge, endCoil2Charge, &OCR1B);
+  // Só antes da carga começar, e nunca depois da faísca agendada
+  uint32_t tick = US_TO_SCHED_TICKS(chargeTime);
+  if (schedule->status == SCHED_PENDING &&
+      (int32_t)(schedule->endTick - tick) > 0 &&
+      queueMove(EVT_IGN1_CHARGE + 2 * (channel - 1), tick)) {
+    schedule->startTick = tick;
+    serviceQueue();
   }
+
+  SREG = oldSREG;
+}
+
+void retimeIgnitionSpark(volatile IgnitionSchedule* schedule, uint32_t sparkTime) {
+  uint8_t channel = schedule->channel;
+  if (channel == 0 || channel > BOARD_IGN_CHANNELS) return;
+
+  uint8_t oldSREG = SREG;
+  cli();
+
+  // Com a carga ainda pendente, a faísca não pode passar para antes dela:
+  // a bobina ficaria carregando sem faísca agendada
+  uint32_t tick = US_TO_SCHED_TICKS(sparkTime);
+  bool valid = (schedule->status == SCHED_RUNNING) ||
+               (schedule->status == SCHED_PENDING && (int32_t)(tick - schedule->startTick) > 0);
+  if (valid && queueMove(EVT_IGN1_SPARK + 2 * (channel - 1), tick)) {
+    schedule->endTick = tick;
+    serviceQueue();
+  }
+
+  SREG = oldSREG;
 }
 
 void clearIgnitionSchedule(volatile IgnitionSchedule* schedule) {
+  uint8_t oldSREG = SREG;
+  cli();
+
   schedule->status = SCHED_OFF;
 
   // Desliga bobina se estava carregando
@@ -213,79 +494,29 @@ void clearIgnitionSchedule(volatile IgnitionSchedule* schedule) {
   } else if (schedule->channel == 2) {
     endCoil2Charge();
   }
-}
-
-// ============================================================================
-// INJEÇÃO VIA POLLING - Implementação
-// ============================================================================
-
-// Estados globais dos injetores
-InjectorPollingState injector1Polling = {false, false, 0, 0};
-InjectorPollingState injector2Polling = {false, false, 0, 0};
-InjectorPollingState injector3Polling = {false, false, 0, 0};
-
-void scheduleInjectorPolling(InjectorPollingState* injState, uint32_t startDelay, uint16_t pulseWidth) {
-  uint32_t now = micros();
-  injState->openTime = now + startDelay;
-  injState->closeTime = injState->openTime + pulseWidth;
-  injState->isScheduled = true;
-  injState->isOpen = false;
-}
 
-void processInjectorPolling() {
-  uint32_t now = micros();
-
-  // Injector 1
-  if (injector1Polling.isScheduled) {
-    if (!injector1Polling.isOpen && now >= injector1Polling.openTime) {
-      // Hora de abrir
-      openInjector1();
-      injector1Polling.isOpen = true;
-    } else if (injector1Polling.isOpen && now >= injector1Polling.closeTime) {
-      // Hora de fechar
-      closeInjector1();
-      injector1Polling.isOpen = false;
-      injector1Polling.isScheduled = false;
-    }
-  }
-
-  // Injector 2
-  if (injector2Polling.isScheduled) {
-    if (!injector2Polling.isOpen && now >= injector2Polling.openTime) {
-      openInjector2();
-      injector2Polling.isOpen = true;
-    } else if (injector2Polling.isOpen && now >= injector2Polling.closeTime) {
-      closeInjector2();
-      injector2Polling.isOpen = false;
-      injector2Polling.isScheduled = false;
-    }
+  if (schedule->channel >= 1 && schedule->channel <= BOARD_IGN_CHANNELS) {
+    queueRemove(EVT_IGN1_CHARGE + 2 * (schedule->channel - 1));
+    serviceQueue();
   }
 
-  // Injector 3
-  if (injector3Polling.isScheduled) {
-    if (!injector3Polling.isOpen && now >= injector3Polling.openTime) {
-      openInjector3();
-      injector3Polling.isOpen = true;
-    } else if (injector3Polling.isOpen && now >= injector3Polling.closeTime) {
-      closeInjector3();
-      injector3Polling.isOpen = false;
-      injector3Polling.isScheduled = false;
-    }
-  }
+  SREG = oldSREG;
 }
 
 // ============================================================================
-// ISRs DO TIMER1 - APENAS IGNIÇÃO (Alta Precisão)
+// ISRs DO TIMER1
 // ============================================================================
-// NOTA: Injeção agora é feita por polling no loop (precisão relaxada OK)
-//       Ignição usa compare match (~±20µs após quantização de 16µs)
+// Os dois compares servem a mesma fila: OCR1A guarda o próximo evento e
+// OCR1B o seguinte. Qualquer um que dispare processa todos os eventos
+// vencidos e rearma os dois.
 
-// ISR para Compare Match A (Ignition Channel 1)
 ISR(TIMER1_COMPA_vect) {
-  handleIgnitionChannel(&ignitionSchedule1, beginCoil1Charge, endCoil1Charge, &OCR1A);
+  serviceQueue();
 }
 
-// ISR para Compare Match B (Ignition Channel 2)
-ISR(TIMER1_COMPB_vect) {
-  handleIgnitionChannel(&ignitionSchedule2, beginCoil2Charge, endCoil2Charge, &OCR1B);
+ISR(TIMER1_COMPB_vect, ISR_ALIASOF(TIMER1_COMPA_vect));
+
+// Overflow: mais uma volta do TCNT1 na escala ativa
+ISR(TIMER1_OVF_vect) {
+  timer1MicrosBase += TIMER1_TURN_US;
 }
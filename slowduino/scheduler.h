@@ -3,7 +3,17 @@
  * @brief Sistema de agendamento de eventos de injeção e ignição
  *
  * Usa Timer1 (16-bit) para agendar aberturas/fechamentos de injetores
- * e carga/descarga de bobinas com precisão de microsegundos
+ * e carga/descarga de bobinas com precisão de microsegundos.
+ *
+ * Todos os eventos (abrir/fechar injetor, carregar bobina/faísca) entram
+ * numa fila ordenada por tempo absoluto do Timer1. Os dois compare
+ * registers (OCR1A e OCR1B) ficam sempre armados com os dois eventos mais
+ * próximos da fila - não há mais um registrador fixo por canal.
+ *
+ * O prescaler do Timer1 alterna entre 256 (16us/tick, baixa rotação) e
+ * 8 (0,5us/tick, alta rotação). A fila guarda os eventos num relógio
+ * estendido de 32 bits em ticks finos (0,5us), que não muda de unidade
+ * quando o prescaler troca.
  */
 
 #ifndef SCHEDULER_H
@@ -12,6 +22,7 @@
 #include <Arduino.h>
 #include "globals.h"
 #include "config.h"
+#include "fastpin.h"
 
 // ============================================================================
 // ESTRUTURAS DE SCHEDULE
@@ -25,20 +36,70 @@ enum ScheduleStatus {
 
 struct FuelSchedule {
   volatile ScheduleStatus status;
-  volatile uint16_t startCompare;     // Valor OCR para início
-  volatile uint16_t endCompare;       // Valor OCR para fim
-  volatile uint16_t duration;         // Duração em ticks do timer
+  volatile uint32_t startTick;        // Abertura (tick fino absoluto)
+  volatile uint32_t endTick;          // Fechamento (tick fino absoluto)
   volatile uint8_t channel;           // Canal (1, 2 ou 3)
 };
 
 struct IgnitionSchedule {
   volatile ScheduleStatus status;
-  volatile uint16_t startCompare;     // Início do dwell (carga)
-  volatile uint16_t endCompare;       // Fim do dwell (faísca)
-  volatile uint16_t duration;         // Duração do dwell em ticks
+  volatile uint32_t startTick;        // Início do dwell (carga)
+  volatile uint32_t endTick;          // Fim do dwell (faísca)
   volatile uint8_t channel;           // Canal (1, 2 ou 3)
 };
 
+// ============================================================================
+// FILA DE EVENTOS DO TIMER1
+// ============================================================================
+
+/**
+ * @brief Ação executada quando um evento da fila vence
+ *
+ * Cada schedule (injetor ou bobina) tem exatamente duas ações: início
+ * (abrir injetor / carregar bobina) e fim (fechar injetor / faísca).
+ */
+enum ScheduleAction : uint8_t {
+  EVT_INJ1_OPEN,
+  EVT_INJ1_CLOSE,
+  EVT_INJ2_OPEN,
+  EVT_INJ2_CLOSE,
+  EVT_INJ3_OPEN,
+  EVT_INJ3_CLOSE,
+  EVT_IGN1_CHARGE,
+  EVT_IGN1_SPARK,
+  EVT_IGN2_CHARGE,
+  EVT_IGN2_SPARK
+};
+
+/**
+ * @brief Evento pendente na fila do scheduler
+ */
+struct ScheduleEvent {
+  uint32_t tick;        // Tick fino absoluto (0,5us) em que o evento vence
+  uint8_t action;       // ScheduleAction
+};
+
+// Cada canal tem no máximo 2 eventos pendentes (início + fim)
+#define SCHED_QUEUE_SIZE  (2 * (BOARD_INJ_CHANNELS + BOARD_IGN_CHANNELS))
+
+// ============================================================================
+// ESCALA DO TIMER1
+// ============================================================================
+
+// Bits que o TCNT1 é deslocado para virar tick fino (0,5us)
+#define TIMER1_SHIFT_FINE     0     // Prescaler 8:   0,5us por tick
+#define TIMER1_SHIFT_COARSE   5     // Prescaler 256: 16us por tick (32 ticks finos)
+
+// Escala ativa (TIMER1_SHIFT_FINE ou TIMER1_SHIFT_COARSE)
+extern volatile uint8_t timer1TickShift;
+
+// Conversão de microsegundos para ticks do hardware na escala ativa
+#define US_TO_TIMER1(us)        ((uint32_t)(((uint32_t)(us) << 1) >> timer1TickShift))
+#define TIMER1_TO_US(ticks)     ((uint32_t)(((uint32_t)(ticks) << timer1TickShift) >> 1))
+
+// Conversão de microsegundos para ticks finos da fila (fixo, 0,5us)
+#define US_TO_SCHED_TICKS(us)   ((uint32_t)(us) << 1)
+
 // Schedules globais
 extern volatile FuelSchedule fuelSchedule1;
 extern volatile FuelSchedule fuelSchedule2;
@@ -60,11 +121,31 @@ void schedulerInit();
 /**
  * @brief Configura Timer1 para scheduler
  *
- * Modo normal (free running) + prescaler 256 (16us por tick)
- * Habilita interrupções de Compare Match
+ * Modo normal (free running) + prescaler 256 (16us por tick) no boot.
+ * Habilita o overflow (relógio estendido); as interrupções de Compare
+ * Match são habilitadas sob demanda, conforme a fila tem algo pendente.
  */
 void setupTimer1();
 
+/**
+ * @brief Escolhe o prescaler do Timer1 conforme a rotação
+ *
+ * Prescaler 8 (0,5us) quando revolutionTime < TIMER1_FINE_ENTER_US e de
+ * volta ao 256 (16us) acima de TIMER1_FINE_EXIT_US ou sem sync (0). A troca
+ * é feita com interrupções desabilitadas e não altera nenhum evento da fila.
+ *
+ * @param revolutionTime Tempo da última revolução (us), 0 se parado
+ */
+void schedulerUpdateResolution(uint32_t revolutionTime);
+
+/**
+ * @brief Aplica a configuração que as ISRs de saída usam
+ *
+ * Recalcula a polaridade das bobinas (configPage2.ignInvert). Chamar no
+ * boot e sempre que a página 4 for alterada pelo TunerStudio.
+ */
+void schedulerApplyConfig();
+
 // ============================================================================
 // FUNÇÕES DE AGENDAMENTO DE INJEÇÃO
 // ============================================================================
@@ -72,12 +153,16 @@ void setupTimer1();
 /**
  * @brief Agenda evento de injeção
  *
+ * Insere abertura e fechamento do injetor na fila de eventos. Pode ser
+ * chamada da ISR do trigger ou do loop (prime pulse) - a fila é protegida
+ * internamente contra interrupções.
+ *
  * @param schedule Ponteiro para struct de schedule
  * @param startTime Tempo de início (microsegundos a partir de agora)
  * @param duration Duração da injeção (microsegundos)
  * @param channel Canal do injetor (1, 2 ou 3)
  */
-void setFuelSchedule(volatile FuelSchedule* schedule, uint16_t startTime, uint16_t duration, uint8_t channel);
+void setFuelSchedule(volatile FuelSchedule* schedule, uint32_t startTime, uint16_t duration, uint8_t channel);
 
 /**
  * @brief Cancela schedule de injeção
@@ -98,6 +183,27 @@ void clearFuelSchedule(volatile FuelSchedule* schedule);
  */
 void setIgnitionSchedule(volatile IgnitionSchedule* schedule, uint32_t startTime, uint16_t duration, uint8_t channel);
 
+/**
+ * @brief Reposiciona o início do dwell de um schedule já agendado
+ *
+ * Usado pelo decoder para reancorar a carga no último dente antes dela.
+ * Ignorado se a carga já começou ou se cairia depois da faísca.
+ *
+ * @param schedule Ponteiro para struct de schedule
+ * @param chargeTime Instante absoluto do início do dwell (base timer1Micros())
+ */
+void retimeIgnitionCharge(volatile IgnitionSchedule* schedule, uint32_t chargeTime);
+
+/**
+ * @brief Reposiciona a faísca de um schedule já agendado
+ *
+ * Ignorado se a faísca já aconteceu ou se cairia antes da carga pendente.
+ *
+ * @param schedule Ponteiro para struct de schedule
+ * @param sparkTime Instante absoluto da faísca (base timer1Micros())
+ */
+void retimeIgnitionSpark(volatile IgnitionSchedule* schedule, uint32_t sparkTime);
+
 /**
  * @brief Cancela schedule de ignição
  */
@@ -106,131 +212,88 @@ void clearIgnitionSchedule(volatile IgnitionSchedule* schedule);
 // ============================================================================
 // CONTROLE DE INJETORES (DIRETO)
 // ============================================================================
+// Acesso direto à porta via FastPin: essas funções rodam dentro da ISR do
+// Timer1 a cada evento, onde o digitalWrite() (~4us) custava caro.
 
 /**
  * @brief Abre injetor 1
  */
 inline void openInjector1() {
-  digitalWrite(PIN_INJECTOR_1, HIGH);
+  FastPin<PIN_INJECTOR_1>::high();
 }
 
 /**
  * @brief Fecha injetor 1
  */
 inline void closeInjector1() {
-  digitalWrite(PIN_INJECTOR_1, LOW);
+  FastPin<PIN_INJECTOR_1>::low();
 }
 
 /**
  * @brief Abre injetor 2
  */
 inline void openInjector2() {
-  digitalWrite(PIN_INJECTOR_2, HIGH);
+  FastPin<PIN_INJECTOR_2>::high();
 }
 
 /**
  * @brief Fecha injetor 2
  */
 inline void closeInjector2() {
-  digitalWrite(PIN_INJECTOR_2, LOW);
+  FastPin<PIN_INJECTOR_2>::low();
 }
 
 /**
  * @brief Abre injetor 3
  */
 inline void openInjector3() {
-  digitalWrite(PIN_INJECTOR_3, HIGH);
+  FastPin<PIN_INJECTOR_3>::high();
 }
 
 /**
  * @brief Fecha injetor 3
  */
 inline void closeInjector3() {
-  digitalWrite(PIN_INJECTOR_3, LOW);
+  FastPin<PIN_INJECTOR_3>::low();
 }
 
 // ============================================================================
 // CONTROLE DE IGNIÇÃO (DIRETO)
 // ============================================================================
 
+// Nível do pino que carrega a bobina (true = HIGH). Pré-calculado a partir de
+// configPage2.ignInvert por schedulerApplyConfig(), para a ISR não consultar a
+// configuração a cada faísca.
+extern volatile bool coilChargeLevel;
+
 /**
  * @brief Inicia carga da bobina 1 (dwell)
  */
 inline void beginCoil1Charge() {
-  if (configPage2.ignInvert) {
-    digitalWrite(PIN_IGNITION_1, LOW);   // Invertido
-  } else {
-    digitalWrite(PIN_IGNITION_1, HIGH);  // Normal
-  }
+  FastPin<PIN_IGNITION_1>::write(coilChargeLevel);
 }
 
 /**
  * @brief Termina carga da bobina 1 (faísca)
  */
 inline void endCoil1Charge() {
-  if (configPage2.ignInvert) {
-    digitalWrite(PIN_IGNITION_1, HIGH);
-  } else {
-    digitalWrite(PIN_IGNITION_1, LOW);
-  }
+  FastPin<PIN_IGNITION_1>::write(!coilChargeLevel);
 }
 
 /**
  * @brief Inicia carga da bobina 2
  */
 inline void beginCoil2Charge() {
-  if (configPage2.ignInvert) {
-    digitalWrite(PIN_IGNITION_2, LOW);
-  } else {
-    digitalWrite(PIN_IGNITION_2, HIGH);
-  }
+  FastPin<PIN_IGNITION_2>::write(coilChargeLevel);
 }
 
 /**
  * @brief Termina carga da bobina 2
  */
 inline void endCoil2Charge() {
-  if (configPage2.ignInvert) {
-    digitalWrite(PIN_IGNITION_2, HIGH);
-  } else {
-    digitalWrite(PIN_IGNITION_2, LOW);
-  }
+  FastPin<PIN_IGNITION_2>::write(!coilChargeLevel);
 }
 
-// ============================================================================
-// INJEÇÃO VIA POLLING (Precisão Relaxada ±100µs)
-// ============================================================================
-
-/**
- * @brief Estado de um injetor para controle via polling
- */
-struct InjectorPollingState {
-  bool isScheduled;     // Tem agendamento pendente
-  bool isOpen;          // Injetor atualmente aberto
-  uint32_t openTime;    // Tempo absoluto para abrir (micros)
-  uint32_t closeTime;   // Tempo absoluto para fechar (micros)
-};
-
-// Estados globais dos 3 injetores
-extern InjectorPollingState injector1Polling;
-extern InjectorPollingState injector2Polling;
-extern InjectorPollingState injector3Polling;
-
-/**
- * @brief Agenda injeção via polling (chamado na ISR do trigger)
- *
- * @param injState Ponteiro para estado do injetor
- * @param startDelay Delay até abertura (microsegundos)
- * @param pulseWidth Duração da injeção (microsegundos)
- */
-void scheduleInjectorPolling(InjectorPollingState* injState, uint32_t startDelay, uint16_t pulseWidth);
-
-/**
- * @brief Processa polling de injetores (chamado no loop)
- * DEVE ser chamado a cada iteração do loop principal (alta prioridade)
- */
-void processInjectorPolling();
-
 // ============================================================================
 // UTILITÁRIOS
 // ============================================================================
@@ -243,17 +306,25 @@ inline uint16_t getTimer1Count() {
 }
 
 /**
- * @brief Define valor de compare do Timer1 Channel A
+ * @brief Base de tempo monotônica de 32 bits em microsegundos
+ *
+ * Substitui micros(): lê o Timer1 (TCNT1 + contador de overflow) em vez do
+ * Timer0, então decoders e scheduler ficam no mesmo domínio de relógio.
+ * Resolução de 16us (prescaler 256) ou 0,5us (prescaler 8), conforme a
+ * rotação. Dá a volta a cada ~71 min, como micros(). Pode ser chamada de
+ * dentro de ISRs.
  */
-inline void setTimer1CompareA(uint16_t value) {
-  OCR1A = value;
-}
+uint32_t timer1Micros();
 
 /**
- * @brief Define valor de compare do Timer1 Channel B
+ * @brief Converte um valor capturado no ICR1 para a base de tempo (us)
+ *
+ * Usado pelo trigger em modo input capture (TRIGGER_USE_ICP1). Chamar com
+ * interrupções desabilitadas, logo após a captura (dentro da ISR).
+ *
+ * @param capture Valor lido do ICR1
+ * @return Instante da borda na mesma escala de timer1Micros()
  */
-inline void setTimer1CompareB(uint16_t value) {
-  OCR1B = value;
-}
+uint32_t timer1CaptureMicros(uint16_t capture);
 
 #endif // SCHEDULER_H
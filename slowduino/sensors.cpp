@@ -4,10 +4,207 @@
  */
 
 #include "sensors.h"
+#include "scheduler.h"
 
 // Variáveis estáticas para cálculo de TPSdot
 static uint32_t lastTPSReadTime = 0;
 
+// ============================================================================
+// AMOSTRADOR DO ADC (ADC_vect)
+// ============================================================================
+
+// Todos os sensores estão em A0..A7 nas duas placas: canal = pino - A0, sem
+// MUX5 (ADCSRB) no Mega
+#define ADC_CHANNEL(pin)  ((uint8_t)((pin) - A0))
+
+struct AdcChannelConfig {
+  uint8_t admux;        // REFS0 (AVcc) | canal
+  uint8_t rateMask;     // Converte quando (volta & rateMask) == 0
+  uint8_t count;        // Conversões por resultado (2^oversample)
+  uint8_t shift;        // Decimação: resultado = soma >> shift
+};
+
+#define ADC_CONFIG(pin, rate, oversample, extraBits) \
+  { (uint8_t)((1 << REFS0) | ADC_CHANNEL(pin)), (uint8_t)((1 << (rate)) - 1), \
+    (uint8_t)(1 << (oversample)), (uint8_t)((oversample) - (extraBits)) }
+
+// Na ordem de AdcSlot
+static const AdcChannelConfig adcChannels[ADC_SLOT_COUNT] PROGMEM = {
+  ADC_CONFIG(PIN_MAP,           ADC_RATE_MAP,  ADC_OVERSAMPLE_MAP,  ADC_EXTRA_BITS_MAP),
+  ADC_CONFIG(PIN_TPS,           ADC_RATE_TPS,  ADC_OVERSAMPLE_TPS,  ADC_EXTRA_BITS_TPS),
+  ADC_CONFIG(PIN_CLT,           ADC_RATE_SLOW, ADC_OVERSAMPLE_SLOW, 0),
+  ADC_CONFIG(PIN_IAT,           ADC_RATE_SLOW, ADC_OVERSAMPLE_SLOW, 0),
+  ADC_CONFIG(PIN_O2,            ADC_RATE_O2,   ADC_OVERSAMPLE_O2,   0),
+  ADC_CONFIG(PIN_BAT,           ADC_RATE_SLOW, ADC_OVERSAMPLE_SLOW, 0),
+  ADC_CONFIG(PIN_OIL_PRESSURE,  ADC_RATE_SLOW, ADC_OVERSAMPLE_SLOW, 0),
+  ADC_CONFIG(PIN_FUEL_PRESSURE, ADC_RATE_SLOW, ADC_OVERSAMPLE_SLOW, 0)
+};
+
+static_assert(sizeof(configPage1.cltCalibration) == CALIBRATION_POINTS &&
+              sizeof(configPage1.iatCalibration) == CALIBRATION_POINTS &&
+              sizeof(configPage2.o2Calibration) == CALIBRATION_POINTS,
+              "curvas de calibração fora de CALIBRATION_POINTS");
+static_assert(ADC_RATE_MAP == 0, "o MAP precisa ser convertido a toda volta");
+static_assert(ADC_OVERSAMPLE_MAP <= 6 && ADC_OVERSAMPLE_TPS <= 6 &&
+              ADC_OVERSAMPLE_O2 <= 6 && ADC_OVERSAMPLE_SLOW <= 6,
+              "soma da sobreamostragem não cabe em uint16_t");
+static_assert(ADC_EXTRA_BITS_MAP * 2 <= ADC_OVERSAMPLE_MAP &&
+              ADC_EXTRA_BITS_TPS * 2 <= ADC_OVERSAMPLE_TPS,
+              "cada bit extra precisa de 4x conversões");
+
+// MAP por ciclo: acumuladores de uma volta
+struct MapRevolution {
+  uint32_t sum;
+  uint16_t count;
+  uint16_t minimum;
+};
+
+static volatile uint16_t adcResults[ADC_SLOT_COUNT];
+static uint16_t adcSum[ADC_SLOT_COUNT];
+static uint8_t adcCount[ADC_SLOT_COUNT];
+static uint8_t adcSlot;
+static uint8_t adcRound;
+
+volatile bool mapRevolutionMark = false;
+static MapRevolution mapRevolution;                 // Volta em andamento (só a ISR)
+static volatile MapRevolution mapRevolutionDone[2]; // Duas últimas voltas fechadas
+static volatile uint8_t mapRevolutionSeq;           // Voltas fechadas (a última está em seq & 1)
+
+// Cada conversão do MAP entra na volta em andamento; no dente #1 a volta é
+// fechada. Só somas e comparações aqui - a divisão fica para o readMAP().
+static inline void mapCycleSample(uint16_t value) {
+  if (mapRevolutionMark) {
+    mapRevolutionMark = false;
+    uint8_t seq = mapRevolutionSeq + 1;
+    volatile MapRevolution& done = mapRevolutionDone[seq & 1];
+    done.sum = mapRevolution.sum;
+    done.count = mapRevolution.count;
+    done.minimum = mapRevolution.minimum;
+    mapRevolutionSeq = seq;
+
+    mapRevolution.sum = 0;
+    mapRevolution.count = 0;
+    mapRevolution.minimum = 0xFFFF;
+  }
+
+  if (mapRevolution.count != 0xFFFF) {
+    mapRevolution.sum += value;
+    mapRevolution.count++;
+  }
+  if (value < mapRevolution.minimum) mapRevolution.minimum = value;
+}
+
+uint16_t adcLatest(uint8_t slot) {
+  noInterrupts();
+  uint16_t value = adcResults[slot];
+  interrupts();
+  return value;
+}
+
+/**
+ * Fim de conversão: acumula o resultado, escolhe o próximo canal devido e
+ * dispara a conversão seguinte (~9,6k conversões/s no total).
+ *
+ * ISR_NOBLOCK: reabilita as interrupções na entrada para não atrasar o
+ * trigger nem o Timer1. Não há reentrada - a próxima ADC_vect só existe
+ * depois do ADSC no fim desta ISR, ~104us mais tarde.
+ */
+ISR(ADC_vect, ISR_NOBLOCK) {
+  uint16_t value = ADC;
+  uint8_t slot = adcSlot;
+  const AdcChannelConfig* cfg = &adcChannels[slot];
+
+  if (slot == ADC_SLOT_MAP) mapCycleSample(value);
+
+  // Decimação: só um deslocamento - MAP/TPS saem em 12 bits, os demais
+  // com a média em 10 bits
+  uint16_t sum = adcSum[slot] + value;
+  uint8_t count = adcCount[slot] + 1;
+  if (count >= pgm_read_byte(&cfg->count)) {
+    adcResults[slot] = sum >> pgm_read_byte(&cfg->shift);
+    sum = 0;
+    count = 0;
+  }
+  adcSum[slot] = sum;
+  adcCount[slot] = count;
+
+  // Próximo canal devido nesta volta (o MAP, slot 0, sempre é)
+  uint8_t round = adcRound;
+  do {
+    if (++slot == ADC_SLOT_COUNT) {
+      slot = 0;
+      round++;
+    }
+  } while (round & pgm_read_byte(&adcChannels[slot].rateMask));
+  adcRound = round;
+  adcSlot = slot;
+
+  // Canal trocado antes do ADSC: a conversão já sai do canal novo
+  ADMUX = pgm_read_byte(&adcChannels[slot].admux);
+  ADCSRA |= (1 << ADSC);
+}
+
+static void adcSamplerStart() {
+  for (uint8_t i = 0; i < ADC_SLOT_COUNT; i++) {
+    adcSum[i] = 0;
+    adcCount[i] = 0;
+  }
+  adcSlot = ADC_SLOT_MAP;
+  adcRound = 0;
+  mapRevolution.sum = 0;
+  mapRevolution.count = 0;
+  mapRevolution.minimum = 0xFFFF;
+
+  // Conversão única disparada pela própria ISR (sem ADATE: o canal seguinte
+  // é escolhido antes de cada conversão). Prescaler 128 -> 125kHz.
+  ADMUX = pgm_read_byte(&adcChannels[ADC_SLOT_MAP].admux);
+  ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+  ADCSRA |= (1 << ADSC);
+}
+
+// ============================================================================
+// CONVERSÕES
+// ============================================================================
+
+static int8_t clampToInt8(int32_t value) {
+  if (value > 127) return 127;
+  if (value < -128) return -128;
+  return (int8_t)value;
+}
+
+// currentStatus.coolant/IAT são int8_t: a curva vai até 215°C
+static int8_t calibratedTemperature(const uint8_t* table, uint16_t adc) {
+  return clampToInt8((int16_t)calibrationLookup(table, adc) - CALIBRATION_TEMP_OFFSET);
+}
+
+// mapADC (12 bits) -> kPa * 10 e kPa. O PW usa MAPx10; as tabelas, o kPa.
+static void convertMAP() {
+  uint16_t mapX10 = fastMap(currentStatus.mapADC, 0, ADC_MAP_MAX,
+                            (uint16_t)configPage1.mapMin * 10, (uint16_t)configPage1.mapMax * 10);
+
+  // Limita (10-255 kPa)
+  if (mapX10 < 100) mapX10 = 100;
+  if (mapX10 > 2550) mapX10 = 2550;
+
+  currentStatus.MAPx10 = mapX10;
+  currentStatus.MAP = (uint8_t)((mapX10 + 5) / 10);
+}
+
+// tpsADC (12 bits) -> 0,5% e %. tpsMin/tpsMax continuam em ADC de 8 bits.
+static void convertTPS() {
+  uint16_t tpsMin = (uint16_t)configPage1.tpsMin << (2 + ADC_EXTRA_BITS_TPS);
+  uint16_t tpsMax = (uint16_t)configPage1.tpsMax << (2 + ADC_EXTRA_BITS_TPS);
+
+  if (currentStatus.tpsADC <= tpsMin) {
+    currentStatus.TPSx2 = 0;
+  } else if (currentStatus.tpsADC >= tpsMax) {
+    currentStatus.TPSx2 = 200;
+  } else {
+    currentStatus.TPSx2 = (uint8_t)fastMap(currentStatus.tpsADC, tpsMin, tpsMax, 0, 200);
+  }
+  currentStatus.TPS = currentStatus.TPSx2 >> 1;
+}
+
 // ============================================================================
 // INICIALIZAÇÃO
 // ============================================================================
@@ -23,9 +220,9 @@ void sensorsInit() {
   pinMode(PIN_OIL_PRESSURE, INPUT);
   pinMode(PIN_FUEL_PRESSURE, INPUT);
 
-  // Realiza leituras iniciais (sem filtro)
-  currentStatus.mapADC = analogRead(PIN_MAP);
-  currentStatus.tpsADC = analogRead(PIN_TPS);
+  // Realiza leituras iniciais (sem filtro), MAP/TPS na escala de 12 bits
+  currentStatus.mapADC = (uint16_t)analogRead(PIN_MAP) << ADC_EXTRA_BITS_MAP;
+  currentStatus.tpsADC = (uint16_t)analogRead(PIN_TPS) << ADC_EXTRA_BITS_TPS;
   currentStatus.cltADC = analogRead(PIN_CLT);
   currentStatus.iatADC = analogRead(PIN_IAT);
   currentStatus.o2ADC = analogRead(PIN_O2);
@@ -34,17 +231,29 @@ void sensorsInit() {
   currentStatus.fuelPressADC = analogRead(PIN_FUEL_PRESSURE);
 
   // Converte valores iniciais
-  currentStatus.MAP = fastMap(currentStatus.mapADC, 0, 1023, configPage1.mapMin, configPage1.mapMax);
-  currentStatus.TPS = fastMap(currentStatus.tpsADC, adc8to10(configPage1.tpsMin), adc8to10(configPage1.tpsMax), 0, 100);
-  currentStatus.coolant = ntcToCelsius(currentStatus.cltADC);
-  currentStatus.IAT = ntcToCelsius(currentStatus.iatADC);
-  currentStatus.O2 = adc10to8(currentStatus.o2ADC);
+  convertMAP();
+  convertTPS();
+  currentStatus.coolant = calibratedTemperature(configPage1.cltCalibration, currentStatus.cltADC);
+  currentStatus.IAT = calibratedTemperature(configPage1.iatCalibration, currentStatus.iatADC);
+  currentStatus.O2 = calibrationLookup(configPage2.o2Calibration, currentStatus.o2ADC);
   currentStatus.battery10 = (uint8_t)(((uint32_t)currentStatus.batADC * ADC_VREF * BAT_MULTIPLIER) / (1024UL * 1000UL));
   currentStatus.oilPressure = (uint8_t)fastMap(currentStatus.oilPressADC, 0, 1023, 0, 250);  // 0-1000 kPa em escala 0-250
   currentStatus.fuelPressure = (uint8_t)fastMap(currentStatus.fuelPressADC, 0, 1023, 0, 250);
 
-  currentStatus.TPSlast = currentStatus.TPS;
-  lastTPSReadTime = micros();
+  currentStatus.TPSx2last = currentStatus.TPSx2;
+  lastTPSReadTime = timer1Micros();
+
+  // Semeia os resultados com as leituras iniciais e liga o amostrador - a
+  // partir daqui o ADC é só da ADC_vect
+  adcResults[ADC_SLOT_MAP] = currentStatus.mapADC;
+  adcResults[ADC_SLOT_TPS] = currentStatus.tpsADC;
+  adcResults[ADC_SLOT_CLT] = currentStatus.cltADC;
+  adcResults[ADC_SLOT_IAT] = currentStatus.iatADC;
+  adcResults[ADC_SLOT_O2] = currentStatus.o2ADC;
+  adcResults[ADC_SLOT_BAT] = currentStatus.batADC;
+  adcResults[ADC_SLOT_OIL] = currentStatus.oilPressADC;
+  adcResults[ADC_SLOT_FUEL] = currentStatus.fuelPressADC;
+  adcSamplerStart();
 
   DEBUG_PRINTLN(F("Sensores inicializados"));
 }
@@ -53,19 +262,75 @@ void sensorsInit() {
 // LEITURA DE MAP
 // ============================================================================
 
+// Leitura por ciclo (só o loop)
+static uint8_t mapLastSeq = 0;
+static uint8_t mapCycleRevs = 0;       // Voltas fechadas desde que o modo por ciclo entrou
+static uint32_t mapLastInstant = 0;
+
+// Média ou mínimo das últimas `window` voltas, em ADC de 10 bits. Retorna
+// false se não fechou volta nova ou se ainda não há `window` voltas inteiras
+// com sincronismo (a primeira volta fechada começou antes dele).
+static bool mapCycleValue(uint8_t window, uint16_t& value) {
+  noInterrupts();
+  uint8_t seq = mapRevolutionSeq;
+  volatile MapRevolution& last = mapRevolutionDone[seq & 1];
+  uint32_t sum = last.sum;
+  uint32_t count = last.count;
+  uint16_t minimum = last.minimum;
+  if (window > 1) {
+    volatile MapRevolution& prev = mapRevolutionDone[(seq & 1) ^ 1];
+    sum += prev.sum;
+    count += prev.count;
+    if (prev.minimum < minimum) minimum = prev.minimum;
+  }
+  interrupts();
+
+  uint8_t newRevs = seq - mapLastSeq;
+  mapLastSeq = seq;
+  mapCycleRevs = (mapCycleRevs > (uint8_t)(255 - newRevs)) ? 255 : (mapCycleRevs + newRevs);
+
+  if (newRevs == 0 || mapCycleRevs <= window || count == 0) return false;
+
+  // Média com os bits extras da decimação: a soma de uma volta tem dezenas
+  // de conversões, então a média em 12 bits não é só um deslocamento
+  value = (configPage1.mapSample == MAP_SAMPLE_MINIMUM)
+        ? (uint16_t)(minimum << ADC_EXTRA_BITS_MAP)
+        : (uint16_t)((sum << ADC_EXTRA_BITS_MAP) / count);
+  return true;
+}
+
 void readMAP() {
-  // Lê ADC
-  uint16_t rawADC = analogRead(PIN_MAP);
+  uint16_t rawADC;
+
+  // Motor de cilindros ímpares: um evento de admissão a cada 720°/n, então
+  // uma volta só não cobre o ciclo (1 cilindro: volta com admissão, volta sem)
+  uint8_t window = (configPage1.nCylinders & 1) ? 2 : 1;
+
+  bool cycleMode = (configPage1.mapSample != MAP_SAMPLE_INSTANT) && currentStatus.hasSync;
+
+  if (cycleMode && mapCycleValue(window, rawADC)) {
+    // Volta nova: valor do ciclo
+  } else if (cycleMode && mapCycleRevs > window) {
+    return;  // Volta em andamento: mantém o MAP da última
+  } else {
+    // Instantâneo (configurado, sem sincronismo ou nas primeiras voltas)
+    if (!cycleMode) {
+      mapLastSeq = mapRevolutionSeq;
+      mapCycleRevs = 0;
+    }
+
+    uint32_t now = millis();
+    if ((now - mapLastInstant) < MAP_INSTANT_INTERVAL) return;
+    mapLastInstant = now;
+
+    // Último resultado do amostrador (não espera conversão)
+    rawADC = adcLatest(ADC_SLOT_MAP);
+  }
 
   // Aplica filtro
   currentStatus.mapADC = applyFilter(rawADC, currentStatus.mapADC, configPage1.mapFilter);
 
-  // Converte para kPa usando calibração
-  currentStatus.MAP = fastMap(currentStatus.mapADC, 0, 1023, configPage1.mapMin, configPage1.mapMax);
-
-  // Limita
-  if (currentStatus.MAP < 10) currentStatus.MAP = 10;    // Mínimo 10 kPa
-  if (currentStatus.MAP > 255) currentStatus.MAP = 255;  // Máximo 255 kPa
+  convertMAP();
 }
 
 // ============================================================================
@@ -73,33 +338,23 @@ void readMAP() {
 // ============================================================================
 
 void readTPS() {
-  uint32_t now = micros();
+  uint32_t now = timer1Micros();
 
-  // Lê ADC
-  uint16_t rawADC = analogRead(PIN_TPS);
+  // Último resultado do amostrador (não espera conversão)
+  uint16_t rawADC = adcLatest(ADC_SLOT_TPS);
 
   // Aplica filtro
   currentStatus.tpsADC = applyFilter(rawADC, currentStatus.tpsADC, configPage1.tpsFilter);
 
-  // Converte para 8-bit para economizar espaço
-  uint8_t tpsADC8 = adc10to8(currentStatus.tpsADC);
-
-  // Aplica calibração (0-100%)
-  if (tpsADC8 <= configPage1.tpsMin) {
-    currentStatus.TPS = 0;
-  } else if (tpsADC8 >= configPage1.tpsMax) {
-    currentStatus.TPS = 100;
-  } else {
-    currentStatus.TPS = fastMap(tpsADC8, configPage1.tpsMin, configPage1.tpsMax, 0, 100);
-  }
+  convertTPS();
 
-  // Calcula TPSdot
+  // Calcula TPSdot (em 0,5%: acelerações lentas não somem no arredondamento)
   uint32_t deltaTime = now - lastTPSReadTime;
   if (deltaTime > 0) {
-    currentStatus.TPSdot = calculateTPSdot(currentStatus.TPS, currentStatus.TPSlast, deltaTime);
+    currentStatus.TPSdot = calculateTPSdot(currentStatus.TPSx2, currentStatus.TPSx2last, deltaTime);
 
     // Atualiza histórico
-    currentStatus.TPSlast = currentStatus.TPS;
+    currentStatus.TPSx2last = currentStatus.TPSx2;
     lastTPSReadTime = now;
   }
 }
@@ -109,14 +364,14 @@ void readTPS() {
 // ============================================================================
 
 void readCLT() {
-  // Lê ADC
-  uint16_t rawADC = analogRead(PIN_CLT);
+  // Último resultado do amostrador (não espera conversão)
+  uint16_t rawADC = adcLatest(ADC_SLOT_CLT);
 
   // Aplica filtro forte (temperatura muda lentamente)
   currentStatus.cltADC = applyFilter(rawADC, currentStatus.cltADC, FILTER_CLT);
 
-  // Converte para temperatura
-  currentStatus.coolant = ntcToCelsius(currentStatus.cltADC);
+  // Converte para temperatura pela curva do sensor
+  currentStatus.coolant = calibratedTemperature(configPage1.cltCalibration, currentStatus.cltADC);
 }
 
 // ============================================================================
@@ -124,14 +379,14 @@ void readCLT() {
 // ============================================================================
 
 void readIAT() {
-  // Lê ADC
-  uint16_t rawADC = analogRead(PIN_IAT);
+  // Último resultado do amostrador (não espera conversão)
+  uint16_t rawADC = adcLatest(ADC_SLOT_IAT);
 
   // Aplica filtro
   currentStatus.iatADC = applyFilter(rawADC, currentStatus.iatADC, FILTER_IAT);
 
-  // Converte para temperatura
-  currentStatus.IAT = ntcToCelsius(currentStatus.iatADC);
+  // Converte para temperatura pela curva do sensor
+  currentStatus.IAT = calibratedTemperature(configPage1.iatCalibration, currentStatus.iatADC);
 }
 
 // ============================================================================
@@ -139,16 +394,15 @@ void readIAT() {
 // ============================================================================
 
 void readO2() {
-  // Lê ADC
-  uint16_t rawADC = analogRead(PIN_O2);
+  // Último resultado do amostrador (não espera conversão)
+  uint16_t rawADC = adcLatest(ADC_SLOT_O2);
 
   // Aplica filtro
   currentStatus.o2ADC = applyFilter(rawADC, currentStatus.o2ADC, FILTER_O2);
 
-  // Converte para percentual (0-255, 100 = lambda 1.0)
-  // Sonda narrowband: 0.1V = lean (0%), 0.9V = rich (200%)
-  // Simplificado: ADC direto / 4 = ~0-255
-  currentStatus.O2 = adc10to8(currentStatus.o2ADC);
+  // Converte para percentual (0-255, 100 = lambda 1.0) pela curva da sonda
+  // (padrão: ADC direto / 4 = ~0-255)
+  currentStatus.O2 = calibrationLookup(configPage2.o2Calibration, currentStatus.o2ADC);
 }
 
 // ============================================================================
@@ -156,8 +410,8 @@ void readO2() {
 // ============================================================================
 
 void readBattery() {
-  // Lê ADC
-  uint16_t rawADC = analogRead(PIN_BAT);
+  // Último resultado do amostrador (não espera conversão)
+  uint16_t rawADC = adcLatest(ADC_SLOT_BAT);
 
   // Aplica filtro
   currentStatus.batADC = applyFilter(rawADC, currentStatus.batADC, FILTER_BAT);
@@ -175,8 +429,8 @@ void readBattery() {
 // ============================================================================
 
 void readOilPressure() {
-  // Lê ADC
-  uint16_t rawADC = analogRead(PIN_OIL_PRESSURE);
+  // Último resultado do amostrador (não espera conversão)
+  uint16_t rawADC = adcLatest(ADC_SLOT_OIL);
 
   // Aplica filtro
   currentStatus.oilPressADC = applyFilter(rawADC, currentStatus.oilPressADC, FILTER_OIL_PRESS);
@@ -195,8 +449,8 @@ void readOilPressure() {
 // ============================================================================
 
 void readFuelPressure() {
-  // Lê ADC
-  uint16_t rawADC = analogRead(PIN_FUEL_PRESSURE);
+  // Último resultado do amostrador (não espera conversão)
+  uint16_t rawADC = adcLatest(ADC_SLOT_FUEL);
 
   // Aplica filtro
   currentStatus.fuelPressADC = applyFilter(rawADC, currentStatus.fuelPressADC, FILTER_FUEL_PRESS);
@@ -226,15 +480,9 @@ void readAllSensors() {
 }
 
 // ============================================================================
-// CONVERSÃO NTC -> CELSIUS
+// CONVERSÃO NTC -> CELSIUS (curva padrão)
 // ============================================================================
 
-static int8_t clampToInt8(int32_t value) {
-  if (value > 127) return 127;
-  if (value < -128) return -128;
-  return (int8_t)value;
-}
-
 int8_t ntcToCelsius(uint16_t adc) {
   // Tabela simplificada de conversão NTC 10K @ 25°C (Beta ~3950)
   // Usa aproximação linear por faixas para economia de memória
@@ -243,8 +491,10 @@ int8_t ntcToCelsius(uint16_t adc) {
   // ADC alto = temperatura baixa (resistência alta)
   // ADC baixo = temperatura alta (resistência baixa)
 
-  // Tabela aproximada (valores típicos para NTC 10K com pull-up 10K)
-  const struct {
+  // Tabela aproximada (valores típicos para NTC 10K com pull-up 10K).
+  // static: PROGMEM numa variável automática é ignorado pelo avr-gcc - a
+  // tabela ia para a pilha e pgm_read_word() lia a flash no endereço da RAM
+  static const struct {
     uint16_t adc;
     int16_t temp;  // int8_t não cabe 140/160°C (máx 127) - estourava para -116/-96
   } ntcTable[] PROGMEM = {
@@ -286,20 +536,44 @@ int8_t ntcToCelsius(uint16_t adc) {
   return 25;  // Fallback
 }
 
+// ============================================================================
+// CURVAS DE CALIBRAÇÃO
+// ============================================================================
+
+void calibrationFillDefault(uint8_t* table, uint8_t curve) {
+  for (uint8_t i = 0; i < CALIBRATION_POINTS; i++) {
+    uint16_t adc = (uint16_t)i << CALIBRATION_SHIFT;
+    if (adc > ADC_MAX) adc = ADC_MAX;
+
+    if (curve == CALIBRATION_CURVE_NTC) {
+      table[i] = (uint8_t)(ntcToCelsius(adc) + CALIBRATION_TEMP_OFFSET);
+    } else {
+      table[i] = adc10to8(adc);
+    }
+  }
+}
+
+bool calibrationIsBlank(const uint8_t* table) {
+  for (uint8_t i = 1; i < CALIBRATION_POINTS; i++) {
+    if (table[i] != table[0]) return false;
+  }
+  return true;
+}
+
 // ============================================================================
 // CÁLCULO DE TPSdot
 // ============================================================================
 
-int16_t calculateTPSdot(uint8_t currentTPS, uint8_t lastTPS, uint32_t deltaTimeUs) {
+int16_t calculateTPSdot(uint8_t currentTPSx2, uint8_t lastTPSx2, uint32_t deltaTimeUs) {
   // Evita divisão por zero
   if (deltaTimeUs == 0) return 0;
 
-  // Diferença de TPS
-  int16_t deltaTPS = (int16_t)currentTPS - (int16_t)lastTPS;
+  // Diferença de TPS (0,5%)
+  int16_t deltaTPSx2 = (int16_t)currentTPSx2 - (int16_t)lastTPSx2;
 
   // Converte para %/segundo
-  // TPSdot = (deltaTPS / deltaTimeUs) * 1.000.000
-  int32_t tpsDot = ((int32_t)deltaTPS * 1000000L) / (int32_t)deltaTimeUs;
+  // TPSdot = (deltaTPSx2 / 2 / deltaTimeUs) * 1.000.000
+  int32_t tpsDot = ((int32_t)deltaTPSx2 * 500000L) / (int32_t)deltaTimeUs;
 
   // Limita para caber em int16_t
   if (tpsDot > 32767) tpsDot = 32767;
@@ -3,6 +3,11 @@
  * @brief Leitura e processamento de sensores
  *
  * Gerencia ADC, filtros e conversão de sensores analógicos
+ *
+ * O ADC roda sozinho: a ISR do ADC converte os canais em round-robin,
+ * cada um na sua taxa e com sua sobreamostragem, e guarda o último
+ * resultado. As funções read*() só filtram e convertem esse resultado -
+ * nenhuma delas espera uma conversão (o analogRead() gastava ~112us).
  */
 
 #ifndef SENSORS_H
@@ -12,6 +17,56 @@
 #include "globals.h"
 #include "config.h"
 
+// ============================================================================
+// AMOSTRADOR DO ADC
+// ============================================================================
+
+/**
+ * @brief Posições do amostrador (ordem do round-robin)
+ *
+ * O MAP é o primeiro e é convertido a toda volta (ADC_RATE_MAP = 0): a
+ * busca pelo próximo canal na ISR depende de haver um canal sempre devido.
+ */
+enum AdcSlot : uint8_t {
+  ADC_SLOT_MAP,
+  ADC_SLOT_TPS,
+  ADC_SLOT_CLT,
+  ADC_SLOT_IAT,
+  ADC_SLOT_O2,
+  ADC_SLOT_BAT,
+  ADC_SLOT_OIL,
+  ADC_SLOT_FUEL,
+  ADC_SLOT_COUNT
+};
+
+/**
+ * @brief Último resultado, já decimado
+ *
+ * 10 bits (média da sobreamostragem), ou 12 bits no MAP e no TPS
+ * (ADC_EXTRA_BITS_MAP/TPS, fundo de escala ADC_MAP_MAX/ADC_TPS_MAX).
+ *
+ * Leitura atômica; pode ser chamada a qualquer momento, nunca espera.
+ */
+uint16_t adcLatest(uint8_t slot);
+
+// Fundo de escala do MAP e do TPS depois da decimação
+#define ADC_MAP_MAX  ((1024U << ADC_EXTRA_BITS_MAP) - 1)
+#define ADC_TPS_MAX  ((1024U << ADC_EXTRA_BITS_TPS) - 1)
+
+// Virou uma volta desde a última conversão do MAP (escrito pelo decoder)
+extern volatile bool mapRevolutionMark;
+
+/**
+ * @brief Marca o início de uma volta para a amostragem do MAP por ciclo
+ *
+ * Chamada pelo decoder no dente #1, só com sincronismo. A ISR do ADC fecha
+ * a volta na próxima conversão do MAP: a ISR do trigger não mexe nos
+ * acumuladores, então não há corrida com a ADC_vect que ela interrompeu.
+ */
+inline void mapCycleMark() {
+  mapRevolutionMark = true;
+}
+
 // ============================================================================
 // FUNÇÕES DE LEITURA DE SENSORES
 // ============================================================================
@@ -19,22 +74,31 @@
 /**
  * @brief Inicializa sistema de sensores
  *
- * Configura pinos de entrada e realiza leituras iniciais
+ * Configura pinos de entrada, realiza leituras iniciais e liga o
+ * amostrador do ADC. Depois disso ninguém mais pode chamar analogRead().
  */
 void sensorsInit();
 
 /**
  * @brief Lê sensor MAP (Manifold Absolute Pressure)
  *
- * Lê ADC, aplica filtro IIR e converte para kPa usando calibração.
- * Deve ser chamado frequentemente (1kHz ideal, mínimo 30Hz)
+ * Conforme configPage1.mapSample: média ou mínimo das conversões da última
+ * volta (duas voltas em motores de cilindros ímpares, para cobrir 720°),
+ * atualizado uma vez por volta; ou o último resultado do amostrador a cada
+ * MAP_INSTANT_INTERVAL. Sem sincronismo usa sempre o instantâneo. Aplica
+ * filtro IIR e converte para kPa * 10 (MAPx10) e kPa (MAP) usando
+ * calibração.
+ *
+ * Chamar a cada passada do loop: retorna sem fazer nada quando não há
+ * leitura nova.
  */
 void readMAP();
 
 /**
  * @brief Lê sensor TPS (Throttle Position Sensor)
  *
- * Lê ADC, aplica filtro e converte para percentual (0-100%).
+ * Pega o último resultado do amostrador (12 bits), aplica filtro e
+ * converte para 0,5% (TPSx2, 0-200) e percentual (TPS, 0-100).
  * Calcula também TPSdot (taxa de mudança).
  * Frequência: 30-50Hz
  */
@@ -146,26 +210,59 @@ inline uint16_t adcToMillivolts(uint16_t adc) {
 }
 
 /**
- * @brief Converte temperatura NTC para °C (simplificado)
+ * @brief Converte temperatura NTC para °C (curva padrão)
  *
- * Usa aproximação linear por faixas ao invés de Steinhart-Hart completo.
- * Economiza processamento e memória.
+ * Aproximação linear por faixas de um NTC 10K com pull-up 10K, com busca e
+ * divisão. Não roda mais a cada leitura: só gera a curva padrão de
+ * calibração (calibrationFillDefault()).
  *
  * @param adc Valor ADC do termistor
  * @return Temperatura em °C (-40 a +150)
  */
 int8_t ntcToCelsius(uint16_t adc);
 
+// ============================================================================
+// CURVAS DE CALIBRAÇÃO
+// ============================================================================
+
+// Curvas padrão de calibrationFillDefault()
+#define CALIBRATION_CURVE_NTC   0   // NTC 10K com pull-up 10K (CLT/IAT), °C + 40
+#define CALIBRATION_CURVE_O2    1   // ADC / 4 (O2)
+
+/**
+ * @brief Preenche uma curva de calibração (CALIBRATION_POINTS) com a padrão
+ */
+void calibrationFillDefault(uint8_t* table, uint8_t curve);
+
+/**
+ * @brief Curva em branco? (todos os pontos iguais - EEPROM antiga ou apagada)
+ */
+bool calibrationIsBlank(const uint8_t* table);
+
+/**
+ * @brief Converte um ADC de 10 bits pela curva de calibração
+ *
+ * O(1): o ponto é ADC >> CALIBRATION_SHIFT e a interpolação até o próximo
+ * é um produto e um deslocamento - sem busca e sem divisão.
+ */
+inline uint8_t calibrationLookup(const uint8_t* table, uint16_t adc) {
+  uint8_t index = adc >> CALIBRATION_SHIFT;
+  uint8_t frac = adc & ((1 << CALIBRATION_SHIFT) - 1);
+  int16_t low = table[index];
+  int16_t high = table[index + 1];
+  return (uint8_t)(low + (((high - low) * frac) >> CALIBRATION_SHIFT));
+}
+
 /**
  * @brief Calcula TPSdot (taxa de mudança do TPS)
  *
  * Retorna %/segundo
  *
- * @param currentTPS TPS atual (%)
- * @param lastTPS TPS anterior (%)
+ * @param currentTPSx2 TPS atual (0,5%)
+ * @param lastTPSx2 TPS anterior (0,5%)
  * @param deltaTimeUs Tempo decorrido (microsegundos)
  * @return Taxa de mudança (%/s)
  */
-int16_t calculateTPSdot(uint8_t currentTPS, uint8_t lastTPS, uint32_t deltaTimeUs);
+int16_t calculateTPSdot(uint8_t currentTPSx2, uint8_t lastTPSx2, uint32_t deltaTimeUs);
 
 #endif // SENSORS_H
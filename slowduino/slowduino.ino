@@ -7,16 +7,16 @@
  *
  * ARQUITETURA DE AGENDAMENTO:
  * ---------------------------
- * IGNIÇÃO: Compare Match (Timer1) - Alta precisão (±5µs)
- *   - OCR1A: Ignition Channels 1
- *   - OCR1B: Ignition Channel 2
+ * INJEÇÃO E IGNIÇÃO: Compare Match (Timer1) - Alta precisão (±1 tick)
+ *   - Cada abertura/fechamento de injetor e carga/faísca de bobina entra
+ *     numa fila ordenada por tick absoluto do Timer1
+ *   - OCR1A: próximo evento da fila
+ *   - OCR1B: evento seguinte
+ *   - Tick de 16us em baixa rotação, 0,5us acima de ~3000 RPM
  *
- * INJEÇÃO: Polling no loop - Precisão relaxada (±100µs, ~2-3% do PW)
- *   - processInjectorPolling() executado a cada iteração
- *   - Suficiente para wasted paired (semi-sequential)
- *
- * RAZÃO: Arduino Uno tem apenas 2 compare registers (OCR1A, OCR1B)
- *        Não há hardware suficiente para agendar 6+ eventos simultâneos
+ * RAZÃO: Arduino Uno tem apenas 2 compare registers (OCR1A, OCR1B) para
+ *        até 10 eventos pendentes; multiplexar a fila sobre os dois tira a
+ *        injeção da dependência da latência do loop()
  *
  * @author Alexandre F M SOUZA
  * @version 0.2.1
@@ -141,13 +141,6 @@ void setup() {
 void loop() {
   uint32_t now = millis();
 
-  // ------------------------------------------------------------------------
-  // POLLING DE INJETORES - MÁXIMA PRIORIDADE (DEVE SER PRIMEIRO!)
-  // ------------------------------------------------------------------------
-  // CRÍTICO: Processa abertura/fechamento de injetores via polling
-  // Precisão: ±100µs (tempo de loop típico)
-  processInjectorPolling();
-
   // ------------------------------------------------------------------------
   // COMUNICAÇÃO SERIAL - ALTA PRIORIDADE
   // ------------------------------------------------------------------------
@@ -179,9 +172,14 @@ void loop() {
     lastLoop30Hz = now;
 
     readTPS();
-    readMAP();
   }
 
+  // ------------------------------------------------------------------------
+  // MAP - por volta (média/mínimo do ciclo) ou a cada 33ms (instantâneo);
+  // readMAP() só trabalha quando há leitura nova
+  // ------------------------------------------------------------------------
+  readMAP();
+
   // ------------------------------------------------------------------------
   // Loop 15Hz (~67ms) - RPM e estado
   // ------------------------------------------------------------------------
@@ -191,6 +189,10 @@ void loop() {
     // Calcula RPM
     calculateRPM();
 
+    // Resolução do Timer1 acompanha a rotação (16us parado/cranking,
+    // 0,5us em alta)
+    schedulerUpdateResolution(currentStatus.hasSync ? triggerState.revolutionTime : 0);
+
     // Verifica perda de sincronismo
     checkSyncLoss();
 
@@ -224,15 +226,15 @@ void loop() {
   // ------------------------------------------------------------------------
   // Priming pulse (ao obter primeiro sync)
   // ------------------------------------------------------------------------
-  // Agendado pela MESMA máquina de estados de polling usada pela injeção
-  // normal (em vez de digitalWrite direto): evita que o prime e uma injeção
-  // real disputem o mesmo pino sem coordenação (um fechando/cortando o pulso
-  // do outro logo na primeira sincronização do motor).
+  // Agendado pela MESMA fila de eventos usada pela injeção normal (em vez de
+  // digitalWrite direto): evita que o prime e uma injeção real disputem o
+  // mesmo pino sem coordenação (um fechando/cortando o pulso do outro logo
+  // na primeira sincronização do motor).
   if (!primedFuel && currentStatus.hasSync && currentStatus.RPM > 0) {
     if (configPage1.primePulse > 0) {
       uint16_t primeDuration = (uint16_t)((uint32_t)configPage1.primePulse * 100UL); // ms*10 -> us
-      scheduleInjectorPolling(&injector1Polling, 0, primeDuration);
-      scheduleInjectorPolling(&injector2Polling, 0, primeDuration);
+      setFuelSchedule(&fuelSchedule1, 0, primeDuration, 1);
+      setFuelSchedule(&fuelSchedule2, 0, primeDuration, 2);
     }
     primedFuel = true;
   }
@@ -240,7 +242,35 @@ void loop() {
   // ------------------------------------------------------------------------
   // Lógica de injeção/ignição (depende de sync)
   // ------------------------------------------------------------------------
-  if (currentStatus.hasSync && currentStatus.RPM > 0) {
+  // A ISR do trigger só consome PW/avanço/dwell uma vez por volta: recalcular
+  // a cada passada do loop (milhares de vezes por volta em marcha lenta) só
+  // atrasava o loop. Recalcula uma vez por volta, quando o decoder marca o
+  // dente #1, e quando MAP, RPM ou TPS mudam - as demais entradas (CLT,
+  // bateria, ASE...) entram no cálculo da volta seguinte.
+  static uint16_t calcMAPx10 = 0;
+  static uint16_t calcRPM = 0;
+  static uint8_t calcTPSx2 = 0;
+
+  bool newCycle = triggerNewCycle;
+
+  if (currentStatus.hasSync && currentStatus.RPM > 0 &&
+      (newCycle || currentStatus.MAPx10 != calcMAPx10 ||
+       currentStatus.RPM != calcRPM || currentStatus.TPSx2 != calcTPSx2)) {
+    // bool: leitura/escrita de um byte, atômica no AVR
+    triggerNewCycle = false;
+    calcMAPx10 = currentStatus.MAPx10;
+    calcRPM = currentStatus.RPM;
+    calcTPSx2 = currentStatus.TPSx2;
+
+    // Tabelas VE e de avanço pela velocidade dos últimos dentes, não pela
+    // média da revolução atualizada a 15Hz. Amostrada só no dente #1 (fase
+    // fixa do ciclo): nos recálculos por MAP/TPS no meio da volta, em motores
+    // de 1-2 cilindros, pegaria a oscilação de compressão/combustão e o
+    // combustível/avanço variariam de uma passada para outra. 0 = sem
+    // amostra desde o sync (zerado por calculateRPM/checkSyncLoss).
+    if (newCycle || currentStatus.RPMinstant == 0) {
+      currentStatus.RPMinstant = getInstantRPM();
+    }
 
     // Calcula fora da seção crítica (cálculo pode ser custoso) e só então
     // publica os valores. PW1/PW2/dwell são uint16_t: a ISR do trigger lê
@@ -264,6 +294,19 @@ void loop() {
 
   protectionProcess();
 
+  // ------------------------------------------------------------------------
+  // Snapshot do realtime (1 kHz) - depois dos cálculos, para 'A'/'r' verem
+  // RPM, PW e avanço da mesma volta do loop
+  // ------------------------------------------------------------------------
+  static uint32_t lastSnapshot = 0;
+  if (now != lastSnapshot) {
+    lastSnapshot = now;
+    commsUpdateSnapshot();
+
+    // Datalog em push ('L'): frame com os canais escolhidos, na taxa pedida
+    commsDatalogProcess();
+  }
+
   // ------------------------------------------------------------------------
   // Debug serial (a cada 1 segundo)
   // ------------------------------------------------------------------------
@@ -5,7 +5,9 @@
 
 #include "storage.h"
 #include "tables.h"
+#include "sensors.h"
 #include <EEPROM.h>
+#include <util/crc16.h>
 
 // Forward declarations
 void loadVETable();
@@ -13,10 +15,11 @@ void loadIgnTable();
 void loadCalibrationTables();
 void saveVETable();
 void saveIgnTable();
-void saveCalibrationTables();
 void loadDefaultTables();
 static void enforceBoardLimits();
 static void sanitizeConfigValues();
+static void journalRecover();
+static void journalReset();
 
 // ============================================================================
 // INICIALIZAÇÃO
@@ -36,6 +39,7 @@ void storageInit() {
   } else {
     // Versão OK, carrega configuração
     DEBUG_PRINTLN(F("EEPROM: Carregando configuração"));
+    journalRecover();  // Termina um burn interrompido antes de ler a imagem
     loadAllConfig();
     sanitizeConfigValues();
     enforceBoardLimits();
@@ -108,8 +112,17 @@ void loadIgnTable() {
 }
 
 void loadCalibrationTables() {
-  // TODO: implementar quando tivermos tabelas de calibração CLT/IAT
-  // Por enquanto usaremos valores calculados direto
+  // As curvas moram nas páginas de config (já carregadas e gravadas junto
+  // com elas). Imagem anterior às curvas lê tudo zero: põe a padrão no lugar
+  if (calibrationIsBlank(configPage1.cltCalibration)) {
+    calibrationFillDefault(configPage1.cltCalibration, CALIBRATION_CURVE_NTC);
+  }
+  if (calibrationIsBlank(configPage1.iatCalibration)) {
+    calibrationFillDefault(configPage1.iatCalibration, CALIBRATION_CURVE_NTC);
+  }
+  if (calibrationIsBlank(configPage2.o2Calibration)) {
+    calibrationFillDefault(configPage2.o2Calibration, CALIBRATION_CURVE_O2);
+  }
 }
 
 static void enforceBoardLimits() {
@@ -128,6 +141,19 @@ static void sanitizeConfigValues() {
   if (configPage2.triggerEdge > TRIGGER_EDGE_BOTH) {
     configPage2.triggerEdge = TRIGGER_EDGE_BOTH;
   }
+
+  if (configPage1.injectorLayout != INJ_LAYOUT_SEQUENTIAL) {
+    configPage1.injectorLayout = INJ_LAYOUT_PAIRED;
+  }
+  if (configPage1.injEndAngle > 719) {
+    configPage1.injEndAngle = INJ_ANGLE_DEFAULT;
+  }
+  if (configPage1.mapSample > MAP_SAMPLE_MINIMUM) {
+    configPage1.mapSample = MAP_SAMPLE_INSTANT;
+  }
+  if (configPage2.camInput > CAM_INPUT_SINGLE) {
+    configPage2.camInput = CAM_INPUT_OFF;
+  }
 }
 
 // ============================================================================
@@ -135,13 +161,18 @@ static void sanitizeConfigValues() {
 // ============================================================================
 
 void saveAllConfig() {
+  // EEPROM.write() não convive com a ISR de burn gravando ao mesmo tempo
+  while (storageBurnBusy()) {}
+
   // Atualiza versão
   eepromWriteByte(EEPROM_VERSION_ADDR, EEPROM_DATA_VERSION);
 
   saveConfigPages();
   saveVETable();
   saveIgnTable();
-  saveCalibrationTables();
+
+  // Imagem regravada por inteiro: transação antiga no journal não vale mais
+  journalReset();
 
   DEBUG_PRINTLN(F("EEPROM: Configuração salva"));
 }
@@ -200,8 +231,314 @@ void saveIgnTable() {
   }
 }
 
-void saveCalibrationTables() {
-  // TODO: implementar quando necessário
+// ============================================================================
+// BURN EM SEGUNDO PLANO (EE_READY) COM JOURNAL
+// ============================================================================
+// A imagem é a mesma de saveAllConfig() e continua no lugar de sempre; o que
+// muda é o caminho até ela. Os blocos marcados por storageMarkDirty() são
+// gravados em transações de até EEPROM_JOURNAL_SLOTS blocos:
+//
+//   1. JOURNAL: cada bloco (índice + 16 bytes, copiados da RAM) vai para o
+//      próximo slot do anel do journal
+//   2. COMMIT:  registro (seq, primeiro slot, nº de blocos, CRC16) no slot A
+//      ou B conforme a paridade de seq - é aqui que a transação passa a valer
+//   3. APPLY:   os blocos são copiados do journal para a imagem
+//
+// Queda de energia antes do COMMIT deixa a imagem intocada; depois dele o
+// boot (journalRecover) reaplica a transação mais nova válida. Reaplicar é
+// idempotente, então não existe marca de "já aplicado" para gastar EEPROM. O
+// anel roda a cada transação e os registros alternam A/B, espalhando o
+// desgaste do journal; os blocos da imagem não têm para onde rodar em 1 KB.
+//
+// A ISR grava um byte por interrupção (só os diferentes) - a EE_READY volta
+// quando a escrita termina. Sem nada para gravar, devolve a CPU a cada
+// EEPROM_BURN_SCAN_BYTES passos; a interrupção é por nível e dispara de novo
+// logo em seguida.
+
+struct BurnRegion {
+  uint8_t* ram;
+  uint16_t address;
+  uint16_t length;
+};
+
+static uint8_t burnVersionByte = EEPROM_DATA_VERSION;
+
+static const BurnRegion burnRegions[] PROGMEM = {
+  { &burnVersionByte,               EEPROM_VERSION_ADDR, 1 },
+  { (uint8_t*)&configPage1,         EEPROM_CONFIG1,      sizeof(ConfigPage1) },
+  { (uint8_t*)&configPage2,         EEPROM_CONFIG2,      sizeof(ConfigPage2) },
+  { &veTable.values[0][0],          EEPROM_VE_TABLE,     TABLE_SIZE_X * TABLE_SIZE_Y },
+  { (uint8_t*)veTable.axisX,        EEPROM_VE_AXIS_X,    sizeof(veTable.axisX) },
+  { veTable.axisY,                  EEPROM_VE_AXIS_Y,    sizeof(veTable.axisY) },
+  { (uint8_t*)&ignTable.valuesI[0][0], EEPROM_IGN_TABLE, TABLE_SIZE_X * TABLE_SIZE_Y },
+  { (uint8_t*)ignTable.axisX,       EEPROM_IGN_AXIS_X,   sizeof(ignTable.axisX) },
+  { ignTable.axisY,                 EEPROM_IGN_AXIS_Y,   sizeof(ignTable.axisY) }
+};
+
+#define BURN_REGION_COUNT  (sizeof(burnRegions) / sizeof(burnRegions[0]))
+#define BLOCK_BYTES        (1 << EEPROM_DIRTY_BLOCK_SHIFT)
+
+// Blocos alterados desde o último burn (loop) e os que o burn ainda leva (ISR)
+static uint8_t dirtyBlocks[EEPROM_DIRTY_BLOCKS / 8];
+static uint8_t burnBlocks[EEPROM_DIRTY_BLOCKS / 8];
+
+enum BurnPhase : uint8_t {
+  BURN_IDLE,
+  BURN_JOURNAL,
+  BURN_COMMIT,
+  BURN_APPLY
+};
+
+static volatile uint8_t burnPhase = BURN_IDLE;
+static uint8_t burnBatch[EEPROM_JOURNAL_SLOTS];  // Blocos da transação atual
+static uint8_t burnCount;                         // Blocos na transação
+static uint8_t burnEntry;                         // Bloco em andamento
+static uint8_t burnPos;                           // Byte dentro do bloco/registro
+static uint16_t burnCRC;
+static uint8_t burnRecord[EEPROM_JOURNAL_RECORD];
+
+// Última transação gravada e próximo slot livre do anel (journalRecover)
+static uint8_t journalSeq = 0;
+static uint8_t journalNext = 0;
+
+static inline uint8_t journalSlot(uint8_t first, uint8_t entry) {
+  uint8_t slot = first + entry;
+  return (slot >= EEPROM_JOURNAL_SLOTS) ? slot - EEPROM_JOURNAL_SLOTS : slot;
+}
+
+static inline uint16_t journalEntryAddress(uint8_t slot) {
+  return EEPROM_JOURNAL_ENTRIES + (uint16_t)slot * EEPROM_JOURNAL_ENTRY;
+}
+
+static inline uint16_t journalRecordAddress(uint8_t seq) {
+  return EEPROM_JOURNAL + (seq & 1) * EEPROM_JOURNAL_RECORD;
+}
+
+static uint16_t journalHeaderCRC(uint8_t seq, uint8_t first, uint8_t count) {
+  uint16_t crc = 0xFFFF;
+  crc = _crc_ccitt_update(crc, seq);
+  crc = _crc_ccitt_update(crc, first);
+  return _crc_ccitt_update(crc, count);
+}
+
+// Lê um registro do journal e confere o CRC dele e dos blocos que aponta
+static bool journalReadRecord(uint16_t address, uint8_t* record) {
+  for (uint8_t i = 0; i < EEPROM_JOURNAL_RECORD; i++) {
+    record[i] = eepromReadByte(address + i);
+  }
+  if (record[1] >= EEPROM_JOURNAL_SLOTS || record[2] > EEPROM_JOURNAL_SLOTS) return false;
+
+  uint16_t crc = journalHeaderCRC(record[0], record[1], record[2]);
+  for (uint8_t e = 0; e < record[2]; e++) {
+    uint16_t entry = journalEntryAddress(journalSlot(record[1], e));
+    for (uint8_t p = 0; p < EEPROM_JOURNAL_ENTRY; p++) {
+      crc = _crc_ccitt_update(crc, eepromReadByte(entry + p));
+    }
+  }
+  return crc == (record[3] | ((uint16_t)record[4] << 8));
+}
+
+static void journalRecover() {
+  uint8_t a[EEPROM_JOURNAL_RECORD];
+  uint8_t b[EEPROM_JOURNAL_RECORD];
+  bool validA = journalReadRecord(EEPROM_JOURNAL, a);
+  bool validB = journalReadRecord(EEPROM_JOURNAL + EEPROM_JOURNAL_RECORD, b);
+
+  if (!validA && !validB) {
+    journalSeq = 0;
+    journalNext = 0;
+    return;
+  }
+
+  const uint8_t* newest;
+  if (validA && validB) {
+    newest = ((int8_t)(b[0] - a[0]) > 0) ? b : a;
+  } else {
+    newest = validA ? a : b;
+  }
+
+  journalSeq = newest[0];
+  journalNext = journalSlot(newest[1], newest[2]);
+
+  // Reaplica a transação (no-op se o APPLY tinha terminado)
+  for (uint8_t e = 0; e < newest[2]; e++) {
+    uint16_t entry = journalEntryAddress(journalSlot(newest[1], e));
+    uint8_t block = eepromReadByte(entry);
+    if (block >= (EEPROM_JOURNAL >> EEPROM_DIRTY_BLOCK_SHIFT)) continue;
+
+    for (uint8_t p = 0; p < BLOCK_BYTES; p++) {
+      eepromWriteByte(((uint16_t)block << EEPROM_DIRTY_BLOCK_SHIFT) + p, eepromReadByte(entry + 1 + p));
+    }
+  }
+}
+
+static void journalReset() {
+  // Tudo que estava pendente acabou de ser gravado direto na imagem
+  memset(dirtyBlocks, 0, sizeof(dirtyBlocks));
+
+  // Dois registros vazios válidos: nada a reaplicar no próximo boot
+  for (uint8_t i = 0; i < 2; i++) {
+    uint8_t seq = journalSeq - i;
+    uint16_t crc = journalHeaderCRC(seq, 0, 0);
+    uint16_t address = journalRecordAddress(seq);
+    eepromWriteByte(address, seq);
+    eepromWriteByte(address + 1, 0);
+    eepromWriteByte(address + 2, 0);
+    eepromWriteU16(address + 3, crc);
+  }
+  journalNext = 0;
+}
+
+void storageMarkDirty(const void* ram, uint8_t length) {
+  const uint8_t* p = (const uint8_t*)ram;
+
+  for (uint8_t i = 0; i < BURN_REGION_COUNT; i++) {
+    const uint8_t* base = (const uint8_t*)pgm_read_ptr(&burnRegions[i].ram);
+    uint16_t size = pgm_read_word(&burnRegions[i].length);
+    if (p < base || p >= base + size) continue;
+
+    uint16_t address = pgm_read_word(&burnRegions[i].address) + (uint16_t)(p - base);
+    uint8_t first = address >> EEPROM_DIRTY_BLOCK_SHIFT;
+    uint8_t last = (address + length - 1) >> EEPROM_DIRTY_BLOCK_SHIFT;
+    for (uint8_t block = first; block <= last; block++) {
+      dirtyBlocks[block >> 3] |= (1 << (block & 7));
+    }
+    return;
+  }
+}
+
+// Leitura direta da EEPROM (EEPE já está livre dentro da EE_READY)
+static inline uint8_t burnReadByte(uint16_t address) {
+  EEAR = address;
+  EECR |= (1 << EERE);
+  return EEDR;
+}
+
+// Inicia a escrita do byte se ele mudou. true = EEPROM ocupada até a
+// próxima EE_READY
+static bool burnWriteByte(uint16_t address, uint8_t value) {
+  if (burnReadByte(address) == value) return false;
+
+  // Sequência temporizada: EEPE até 4 ciclos depois de EEMPE. Já estamos com
+  // interrupções desabilitadas (ISR ou storageBurnStart).
+  EEDR = value;
+  EECR |= (1 << EEMPE);
+  EECR |= (1 << EEPE);
+  return true;
+}
+
+// Byte atual da configuração num endereço da imagem: da RAM se cair numa
+// região, senão o que já está na EEPROM (lacunas entre regiões)
+static uint8_t burnSourceByte(uint16_t address) {
+  for (uint8_t i = 0; i < BURN_REGION_COUNT; i++) {
+    uint16_t start = pgm_read_word(&burnRegions[i].address);
+    if (address >= start && address < start + pgm_read_word(&burnRegions[i].length)) {
+      const uint8_t* ram = (const uint8_t*)pgm_read_ptr(&burnRegions[i].ram);
+      return ram[address - start];
+    }
+  }
+  return burnReadByte(address);
+}
+
+// Monta a próxima transação com os blocos pendentes. false = nada a gravar
+static bool burnNextBatch() {
+  burnCount = 0;
+  for (uint8_t block = 0; block < EEPROM_DIRTY_BLOCKS && burnCount < EEPROM_JOURNAL_SLOTS; block++) {
+    uint8_t mask = 1 << (block & 7);
+    if (burnBlocks[block >> 3] & mask) {
+      burnBlocks[block >> 3] &= ~mask;
+      burnBatch[burnCount++] = block;
+    }
+  }
+  if (burnCount == 0) return false;
+
+  journalSeq++;
+  burnCRC = journalHeaderCRC(journalSeq, journalNext, burnCount);
+  burnEntry = 0;
+  burnPos = 0;
+  burnPhase = BURN_JOURNAL;
+  return true;
+}
+
+void storageBurnStart() {
+  noInterrupts();
+  for (uint8_t i = 0; i < sizeof(dirtyBlocks); i++) {
+    burnBlocks[i] |= dirtyBlocks[i];
+    dirtyBlocks[i] = 0;
+  }
+  // Com uma transação em andamento, os blocos novos entram nas próximas
+  if (burnPhase == BURN_IDLE && burnNextBatch()) {
+    EECR |= (1 << EERIE);
+  }
+  interrupts();
+}
+
+bool storageBurnBusy() {
+  // EERIE só cai quando a última escrita terminou
+  return bit_is_set(EECR, EERIE);
+}
+
+ISR(EE_READY_vect) {
+  for (uint8_t step = 0; step < EEPROM_BURN_SCAN_BYTES; step++) {
+    uint16_t address;
+    uint8_t value;
+
+    switch (burnPhase) {
+      case BURN_JOURNAL: {
+        uint8_t block = burnBatch[burnEntry];
+        address = journalEntryAddress(journalSlot(journalNext, burnEntry)) + burnPos;
+        value = (burnPos == 0) ? block
+                : burnSourceByte(((uint16_t)block << EEPROM_DIRTY_BLOCK_SHIFT) + burnPos - 1);
+        burnCRC = _crc_ccitt_update(burnCRC, value);
+
+        if (++burnPos == EEPROM_JOURNAL_ENTRY) {
+          burnPos = 0;
+          if (++burnEntry == burnCount) {
+            burnRecord[0] = journalSeq;
+            burnRecord[1] = journalNext;
+            burnRecord[2] = burnCount;
+            burnRecord[3] = burnCRC & 0xFF;
+            burnRecord[4] = burnCRC >> 8;
+            burnPhase = BURN_COMMIT;
+          }
+        }
+        break;
+      }
+
+      case BURN_COMMIT:
+        address = journalRecordAddress(journalSeq) + burnPos;
+        value = burnRecord[burnPos];
+
+        if (++burnPos == EEPROM_JOURNAL_RECORD) {
+          burnPos = 0;
+          burnEntry = 0;
+          burnPhase = BURN_APPLY;
+        }
+        break;
+
+      case BURN_APPLY: {
+        uint16_t entry = journalEntryAddress(journalSlot(journalNext, burnEntry));
+        value = burnReadByte(entry + 1 + burnPos);
+        address = ((uint16_t)burnBatch[burnEntry] << EEPROM_DIRTY_BLOCK_SHIFT) + burnPos;
+
+        if (++burnPos == BLOCK_BYTES) {
+          burnPos = 0;
+          if (++burnEntry == burnCount) {
+            journalNext = journalSlot(journalNext, burnCount);
+            if (!burnNextBatch()) burnPhase = BURN_IDLE;
+          }
+        }
+        break;
+      }
+
+      default:
+        // Última escrita já terminou (EE_READY): burn concluído
+        EECR &= ~(1 << EERIE);
+        return;
+    }
+
+    if (burnWriteByte(address, value)) return;
+  }
 }
 
 // ============================================================================
@@ -262,11 +599,24 @@ void loadDefaults() {
   configPage1.oilPressureProtHysteresis = 4;
   configPage1.oilPressureProtDelay = 2;
 
+  // Injeção: pareada até o sensor de fase ser configurado
+  configPage1.injectorLayout = INJ_LAYOUT_PAIRED;
+  configPage1.injEndAngle = INJ_ANGLE_DEFAULT;
+
+  // MAP: média do ciclo (tira a pulsação do coletor em 1-2 cilindros)
+  configPage1.mapSample = MAP_SAMPLE_AVERAGE;
+
+  // Calibração: NTC 10K padrão nos dois termistores
+  calibrationFillDefault(configPage1.cltCalibration, CALIBRATION_CURVE_NTC);
+  calibrationFillDefault(configPage1.iatCalibration, CALIBRATION_CURVE_NTC);
+
   // ---- ConfigPage2 (Ignition) ----
   configPage2.triggerPattern = TRIGGER_MISSING_TOOTH;
   configPage2.triggerTeeth = 36;
   configPage2.triggerMissing = 1;
   configPage2.triggerEdge = TRIGGER_EDGE_BOTH;  // Mesmo comportamento anterior (CHANGE)
+  configPage2.camInput = CAM_INPUT_OFF;
+  configPage2.camEdge = TRIGGER_EDGE_RISING;
 
   // Dwell
   configPage2.dwellRun = DWELL_DEFAULT;
@@ -339,6 +689,9 @@ void loadDefaults() {
   configPage2.engineProtectRPM = 70;
   configPage2.engineProtectRPMHysteresis = 3;
 
+  // Sonda O2: ADC / 4, como antes das curvas
+  calibrationFillDefault(configPage2.o2Calibration, CALIBRATION_CURVE_O2);
+
   // ---- Tabelas VE e Ignição ----
   loadDefaultTables();
 }
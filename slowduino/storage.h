@@ -19,8 +19,9 @@
 /**
  * @brief Inicializa sistema de storage
  *
- * Verifica versão da EEPROM e carrega configurações.
- * Se versão inválida ou primeira inicialização, carrega valores padrão.
+ * Verifica versão da EEPROM, termina um burn interrompido (journal) e
+ * carrega configurações. Se versão inválida ou primeira inicialização,
+ * carrega valores padrão.
  */
 void storageInit();
 
@@ -40,7 +41,8 @@ void loadConfigPages();
  * @brief Salva todas as configurações na EEPROM
  *
  * Salva tabelas VE/Ignição e config pages.
- * ATENÇÃO: operação demorada (~100ms)
+ * ATENÇÃO: bloqueia ~3,3ms por byte alterado. Só no boot/reset; com o motor
+ * funcionando use storageBurnStart().
  */
 void saveAllConfig();
 
@@ -63,6 +65,42 @@ void loadDefaults();
  */
 void resetEEPROM();
 
+// ============================================================================
+// BURN EM SEGUNDO PLANO
+// ============================================================================
+// A ISR EE_READY grava um byte por vez (~3,3ms cada) enquanto o loop segue
+// rodando. Só visita os blocos da EEPROM marcados por storageMarkDirty()
+// desde o último burn; o resto da imagem nem é lido. Os blocos passam por um
+// journal com commit (até EEPROM_JOURNAL_SLOTS por transação), então uma
+// queda de energia no meio do burn nunca deixa um bloco pela metade.
+
+/**
+ * @brief Marca um trecho da configuração em RAM como alterado
+ *
+ * Chamar depois de mudar um byte de configPage1/2 ou das tabelas VE/Ignição
+ * (os comandos de escrita de página do TunerStudio fazem isso). Ponteiros
+ * fora dessas estruturas são ignorados.
+ *
+ * @param ram Primeiro byte alterado
+ * @param length Quantidade de bytes
+ */
+void storageMarkDirty(const void* ram, uint8_t length);
+
+/**
+ * @brief Inicia (ou reinicia) o burn em segundo plano
+ *
+ * Retorna na hora. Leva os blocos alterados até aqui; se já houver um burn
+ * em andamento, os blocos novos entram nas transações seguintes dele.
+ */
+void storageBurnStart();
+
+/**
+ * @brief Indica se há burn em andamento
+ *
+ * Vai a false quando o último byte terminou de gravar na EEPROM.
+ */
+bool storageBurnBusy();
+
 // ============================================================================
 // FUNÇÕES AUXILIARES DE LEITURA/ESCRITA
 // ============================================================================
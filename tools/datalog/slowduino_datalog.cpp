@@ -0,0 +1,442 @@
+/**
+ * @file slowduino_datalog.cpp
+ * @brief Recebe o datalog em push do Slowduino e grava em CSV
+ *
+ * Ferramenta de PC (Linux/macOS). Liga o push com o comando 'L' (taxa +
+ * máscara de campos), decodifica os frames e grava um CSV com os valores
+ * já em unidades físicas. Ctrl+C desliga o push e fecha o arquivo.
+ *
+ * Compilar:
+ *   g++ -O2 -std=c++11 -o slowduino_datalog slowduino_datalog.cpp
+ *
+ * Uso:
+ *   slowduino_datalog [-k N] [-b baud] <porta> <taxa Hz> <saida.csv> [campo ...]
+ *   slowduino_datalog /dev/ttyUSB0 50 log.csv rpm map tps pw1 advance
+ *   slowduino_datalog -k 20 /dev/rfcomm0 40 log.csv   (Bluetooth lento)
+ *   slowduino_datalog -k 20 -b 38400 /dev/ttyUSB0 20 log.csv   (HC-05 a 38400)
+ *
+ * Sem campos, grava todos. -k N pede N deltas entre keyframes: entre eles o
+ * ECU manda só os campos que mudaram. -b escolhe a velocidade da porta
+ * (padrão 115200); tem que ser a mesma do SERIAL_BAUD do firmware. A porta
+ * também pode ser um arquivo com bytes capturados (nesse caso nada é
+ * enviado ao ECU).
+ *
+ * Frames (ver comms.cpp, DATALOG EM PUSH):
+ *   Keyframe: [length BE] [0x10] [seq] [tempo ms, uint16 LE]
+ *             [máscara, uint32 LE] [campos escolhidos] [CRC32 BE]
+ *   Delta:    [length BE] [0x11] [seq] [seq de referência] [tempo ms]
+ *             [bitmap dos campos escolhidos que mudaram] [esses campos]
+ *             [CRC32 BE]
+ * Campos na ordem da tabela abaixo. O TunerStudio precisa estar
+ * desconectado da porta.
+ */
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// ============================================================================
+// CAMPOS (mesma ordem de OutputChannels / outputFieldSize no firmware)
+// ============================================================================
+
+struct Field {
+  const char* name;
+  uint8_t size;     // Bytes no frame (little-endian)
+  double scale;     // Físico = (bruto + offset) * scale
+  int offset;
+};
+
+static const Field fields[] = {
+  {"secl",          1, 1.0,   0},
+  {"status1",       1, 1.0,   0},
+  {"engine",        1, 1.0,   0},
+  {"syncLoss",      1, 1.0,   0},
+  {"map",           2, 0.1,   0},    // kPa
+  {"iat",           1, 1.0, -40},    // °C
+  {"coolant",       1, 1.0, -40},    // °C
+  {"batCorrection", 1, 1.0,   0},    // %
+  {"battery",       1, 0.1,   0},    // V
+  {"o2",            1, 1.0,   0},
+  {"egoCorrection", 1, 1.0,   0},    // %
+  {"iatCorrection", 1, 1.0,   0},    // %
+  {"wueCorrection", 1, 1.0,   0},    // %
+  {"rpm",           2, 1.0,   0},
+  {"advance",       1, 1.0, -40},    // graus
+  {"tps",           1, 0.5,   0},    // %
+  {"loopsPerSec",   2, 1.0,   0},
+  {"freeRam",       2, 1.0,   0},    // bytes
+  {"spark",         1, 1.0,   0},
+  {"idleLoad",      1, 1.0,   0},    // %
+  {"baro",          1, 1.0,   0},    // kPa
+  {"pw1",           2, 0.001, 0},    // ms
+  {"pw2",           2, 0.001, 0},    // ms
+  {"pw3",           2, 0.001, 0},    // ms
+  {"idleTarget",    1, 10.0,  0},    // RPM
+  {"ve",            1, 1.0,   0},    // %
+};
+
+static const unsigned FIELD_COUNT = sizeof(fields) / sizeof(fields[0]);
+
+static const uint8_t RC_DATALOG = 0x10;
+static const uint8_t RC_DATALOG_DELTA = 0x11;
+static const unsigned FRAME_HEADER = 7;  // seq + tempo + máscara
+static const unsigned DELTA_HEADER = 4;  // seq + referência + tempo
+
+// ============================================================================
+// CRC32 (mesmo polinômio do firmware)
+// ============================================================================
+
+static uint32_t crc32(const uint8_t* data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// ============================================================================
+// PORTA SERIAL
+// ============================================================================
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+  stopRequested = 1;
+}
+
+// Velocidade em bps para a constante do termios, 0 se não suportada
+static speed_t baudConstant(long baud) {
+  switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 115200: return B115200;
+#ifdef B230400
+    case 230400: return B230400;
+#endif
+    default:     return 0;
+  }
+}
+
+static bool configurePort(int fd, speed_t speed) {
+  termios tty;
+  if (tcgetattr(fd, &tty) != 0) return false;
+  cfmakeraw(&tty);
+  cfsetispeed(&tty, speed);
+  cfsetospeed(&tty, speed);
+  tty.c_cflag |= CLOCAL | CREAD;
+  tty.c_cc[VMIN] = 0;
+  tty.c_cc[VTIME] = 2;  // read() volta a cada 200 ms para checar o Ctrl+C
+  return tcsetattr(fd, TCSANOW, &tty) == 0;
+}
+
+// Envia 'L' no envelope do protocolo moderno: [length BE] [payload] [CRC32 BE]
+static bool sendDatalogCommand(int fd, uint8_t rate, uint32_t mask, uint8_t keyInterval) {
+  uint8_t payload[7] = {'L', rate,
+                        (uint8_t)mask, (uint8_t)(mask >> 8),
+                        (uint8_t)(mask >> 16), (uint8_t)(mask >> 24),
+                        keyInterval};
+  uint32_t crc = crc32(payload, sizeof(payload));
+  uint8_t frame[2 + sizeof(payload) + 4];
+  frame[0] = 0;
+  frame[1] = sizeof(payload);
+  memcpy(&frame[2], payload, sizeof(payload));
+  for (int i = 0; i < 4; i++) frame[2 + sizeof(payload) + i] = (uint8_t)(crc >> (24 - 8 * i));
+  return write(fd, frame, sizeof(frame)) == (ssize_t)sizeof(frame);
+}
+
+// ============================================================================
+// DECODIFICAÇÃO
+// ============================================================================
+
+static unsigned framePayloadLength(uint32_t mask) {
+  unsigned length = 1 + FRAME_HEADER;
+  for (unsigned i = 0; i < FIELD_COUNT; i++) {
+    if (mask & (1u << i)) length += fields[i].size;
+  }
+  return length;
+}
+
+struct Decoder {
+  FILE* out;
+  uint32_t headerMask;   // Máscara das colunas do CSV (0 = ainda não escrito)
+  uint32_t mask;         // Máscara do último keyframe
+  int32_t raw[32];       // Último valor bruto de cada campo
+  bool synced;           // Há um keyframe válido como base para os deltas
+  bool haveLast;
+  uint8_t lastSeq;       // seq do último frame decodificado
+  uint16_t lastTime;
+  uint64_t timeMs;       // Tempo desenrolado (o frame traz só 16 bits)
+  unsigned long frames;
+  unsigned long lost;    // Amostras que não chegaram (saltos no seq)
+  unsigned long skipped; // Deltas sem base (frame de referência perdido)
+  unsigned long badBytes;
+
+  void writeHeader(uint32_t columns) {
+    fprintf(out, "time_ms,seq");
+    for (unsigned i = 0; i < FIELD_COUNT; i++) {
+      if (columns & (1u << i)) fprintf(out, ",%s", fields[i].name);
+    }
+    fprintf(out, "\n");
+    headerMask = columns;
+  }
+
+  // Lê os campos de 'data'; 'present' diz quais dos escolhidos estão no frame
+  // (bit k = k-ésimo campo escolhido)
+  void readFields(const uint8_t* data, uint32_t present) {
+    unsigned k = 0;
+    for (unsigned i = 0; i < FIELD_COUNT; i++) {
+      if (!(mask & (1u << i))) continue;
+      if (present & (1u << k)) {
+        raw[i] = data[0];
+        if (fields[i].size == 2) raw[i] |= data[1] << 8;
+        data += fields[i].size;
+      }
+      k++;
+    }
+  }
+
+  void writeRow(uint8_t seq, uint16_t time) {
+    if (haveLast) {
+      lost += (uint8_t)(seq - lastSeq - 1);
+      timeMs += (uint16_t)(time - lastTime);
+    }
+    haveLast = true;
+    lastSeq = seq;
+    lastTime = time;
+    frames++;
+
+    fprintf(out, "%llu,%u", (unsigned long long)timeMs, seq);
+    for (unsigned i = 0; i < FIELD_COUNT; i++) {
+      if (mask & (1u << i)) fprintf(out, ",%g", (raw[i] + fields[i].offset) * fields[i].scale);
+    }
+    fprintf(out, "\n");
+  }
+
+  void handleKeyframe(const uint8_t* payload, unsigned length) {
+    uint8_t seq = payload[1];
+    uint16_t time = payload[2] | (payload[3] << 8);
+    uint32_t frameMask = payload[4] | (payload[5] << 8) | ((uint32_t)payload[6] << 16) | ((uint32_t)payload[7] << 24);
+    if (framePayloadLength(frameMask) != length) {
+      badBytes += length;
+      return;
+    }
+
+    if (headerMask == 0) writeHeader(frameMask);
+    if (frameMask != headerMask) return;  // Máscara trocada no meio: ignora
+
+    mask = frameMask;
+    readFields(&payload[1 + FRAME_HEADER], 0xFFFFFFFFu);
+    synced = true;
+    writeRow(seq, time);
+  }
+
+  void handleDelta(const uint8_t* payload, unsigned length) {
+    uint8_t seq = payload[1];
+    uint8_t reference = payload[2];
+    uint16_t time = payload[3] | (payload[4] << 8);
+
+    // Delta vale contra o frame 'reference'; se não foi esse o último que
+    // decodificamos, espera o próximo keyframe
+    if (!synced || !haveLast || reference != lastSeq) {
+      synced = false;
+      skipped++;
+      return;
+    }
+
+    unsigned selected = 0;
+    for (unsigned i = 0; i < FIELD_COUNT; i++) {
+      if (mask & (1u << i)) selected++;
+    }
+    unsigned bitmapBytes = (selected + 7) / 8;
+    if (length < 1 + DELTA_HEADER + bitmapBytes) {
+      badBytes += length;
+      return;
+    }
+
+    uint32_t changed = 0;
+    for (unsigned b = 0; b < bitmapBytes; b++) changed |= (uint32_t)payload[1 + DELTA_HEADER + b] << (8 * b);
+
+    unsigned expected = 1 + DELTA_HEADER + bitmapBytes;
+    unsigned k = 0;
+    for (unsigned i = 0; i < FIELD_COUNT; i++) {
+      if (!(mask & (1u << i))) continue;
+      if (changed & (1u << k)) expected += fields[i].size;
+      k++;
+    }
+    if (expected != length) {
+      badBytes += length;
+      return;
+    }
+
+    readFields(&payload[1 + DELTA_HEADER + bitmapBytes], changed);
+    writeRow(seq, time);
+  }
+
+  // Consome frames completos do início de 'buffer'; byte inválido = ressincroniza
+  void feed(std::vector<uint8_t>& buffer) {
+    size_t start = 0;
+    const unsigned maxPayload = framePayloadLength(0xFFFFFFFFu);
+    while (buffer.size() - start >= 2) {
+      unsigned length = (buffer[start] << 8) | buffer[start + 1];
+
+      // Resposta de 1 byte ao 'L' (chega antes do primeiro frame)
+      if (length == 1) {
+        if (buffer.size() - start < 2 + 1 + 4) break;
+        const uint8_t* reply = &buffer[start + 2];
+        uint32_t received = ((uint32_t)reply[1] << 24) | ((uint32_t)reply[2] << 16) |
+                            ((uint32_t)reply[3] << 8) | reply[4];
+        if (received == crc32(reply, 1)) {
+          if (reply[0] != 0) fprintf(stderr, "ECU recusou o comando 'L' (0x%02x)\n", reply[0]);
+          start += 2 + 1 + 4;
+          continue;
+        }
+      }
+
+      if (length < 1 + DELTA_HEADER + 1 || length > maxPayload) {
+        start++;
+        badBytes++;
+        continue;
+      }
+      if (buffer.size() - start < 2 + length + 4) break;
+
+      const uint8_t* payload = &buffer[start + 2];
+      const uint8_t* crcBytes = payload + length;
+      uint32_t received = ((uint32_t)crcBytes[0] << 24) | ((uint32_t)crcBytes[1] << 16) |
+                          ((uint32_t)crcBytes[2] << 8) | crcBytes[3];
+      if ((payload[0] != RC_DATALOG && payload[0] != RC_DATALOG_DELTA) ||
+          received != crc32(payload, length)) {
+        start++;
+        badBytes++;
+        continue;
+      }
+
+      if (payload[0] == RC_DATALOG) {
+        handleKeyframe(payload, length);
+      } else {
+        handleDelta(payload, length);
+      }
+      start += 2 + length + 4;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + start);
+  }
+};
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char** argv) {
+  const char* program = argv[0];
+  int keyInterval = 0;
+  speed_t speed = B115200;
+  while (argc >= 3 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-k") == 0) {
+      keyInterval = atoi(argv[2]);
+      if (keyInterval < 0 || keyInterval > 255) {
+        fprintf(stderr, "-k deve ser 0-255\n");
+        return 1;
+      }
+    } else if (strcmp(argv[1], "-b") == 0) {
+      speed = baudConstant(atol(argv[2]));
+      if (speed == 0) {
+        fprintf(stderr, "-b deve ser 9600, 19200, 38400, 57600 ou 115200\n");
+        return 1;
+      }
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc < 4) {
+    fprintf(stderr, "uso: %s [-k N] [-b baud] <porta> <taxa Hz> <saida.csv> [campo ...]\ncampos:", program);
+    for (unsigned i = 0; i < FIELD_COUNT; i++) fprintf(stderr, " %s", fields[i].name);
+    fprintf(stderr, "\n");
+    return 1;
+  }
+
+  int rate = atoi(argv[2]);
+  if (rate < 1 || rate > 100) {
+    fprintf(stderr, "taxa deve ser 1-100 Hz\n");
+    return 1;
+  }
+
+  uint32_t mask = 0;
+  for (int a = 4; a < argc; a++) {
+    unsigned i = 0;
+    while (i < FIELD_COUNT && strcmp(argv[a], fields[i].name) != 0) i++;
+    if (i == FIELD_COUNT) {
+      fprintf(stderr, "campo desconhecido: %s\n", argv[a]);
+      return 1;
+    }
+    mask |= 1u << i;
+  }
+  if (mask == 0) mask = (1u << FIELD_COUNT) - 1;
+
+  int fd = open(argv[1], O_RDWR | O_NOCTTY);
+  if (fd < 0) fd = open(argv[1], O_RDONLY);
+  if (fd < 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  bool live = isatty(fd);
+  if (live && !configurePort(fd, speed)) {
+    perror("tcsetattr");
+    return 1;
+  }
+
+  FILE* out = fopen(argv[3], "w");
+  if (!out) {
+    perror(argv[3]);
+    return 1;
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  if (live) {
+    usleep(2000000);  // Uno reinicia ao abrir a porta: espera o bootloader
+    tcflush(fd, TCIOFLUSH);
+    if (!sendDatalogCommand(fd, (uint8_t)rate, mask, (uint8_t)keyInterval)) {
+      perror("write");
+      return 1;
+    }
+  }
+
+  Decoder decoder;
+  memset(&decoder, 0, sizeof(decoder));
+  decoder.out = out;
+  std::vector<uint8_t> buffer;
+  uint8_t chunk[256];
+  while (!stopRequested) {
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n < 0) break;
+    if (n == 0) {
+      if (!live) break;  // Fim do arquivo capturado
+      continue;
+    }
+    buffer.insert(buffer.end(), chunk, chunk + n);
+    decoder.feed(buffer);
+  }
+
+  if (live) sendDatalogCommand(fd, 0, 0, 0);  // Desliga o push
+  fclose(out);
+  close(fd);
+
+  fprintf(stderr, "%lu frames, %lu amostras perdidas, %lu deltas sem base, %lu bytes descartados\n",
+          decoder.frames, decoder.lost, decoder.skipped, decoder.badBytes);
+  return 0;
+}
@@ -0,0 +1,15 @@
+/**
+ * @file Arduino.h
+ * @brief Substituto mínimo do Arduino.h para compilar fuel.cpp no PC
+ *
+ * Só o que fuel.cpp e os headers que ele inclui usam; ver fuel_pw_check.cpp.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Mesmo alvo da placa padrão (BOARD_SLOWDUINO)
+#define __AVR_ATmega328P__
+
+#define PROGMEM
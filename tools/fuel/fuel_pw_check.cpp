@@ -0,0 +1,186 @@
+/**
+ * @file fuel_pw_check.cpp
+ * @brief Confere o PW em ponto fixo do firmware contra a fórmula exata
+ *
+ * Ferramenta de PC. Compila o fuel.cpp do firmware (com um Arduino.h
+ * mínimo desta pasta) e compara calculateInjection() com
+ *   floor(reqFuel * VE/100 * MAP/1000 * correções/100) + injOpen
+ * calculado em 128 bits, com os mesmos limites INJ_MIN_PW/INJ_MAX_PW e
+ * CORR_MIN/CORR_MAX. Falha (código 1) se alguma diferença passar de 1us.
+ *
+ * Compilar e rodar (de tools/fuel):
+ *   g++ -O2 -std=gnu++11 -I. -I../../slowduino -o fuel_pw_check fuel_pw_check.cpp
+ *   ./fuel_pw_check
+ *
+ * Entradas cobertas:
+ *   - todo par VE (0-255) x MAPx10 (0-2550), 8 vezes cada, com reqFuel,
+ *     correções, AE e injOpen sorteados;
+ *   - todo reqFuel (0-65535), 8 vezes cada, com o resto sorteado;
+ *   - a grade dos extremos de cada entrada (inclusive correções fora da
+ *     faixa da ini, 0-255%).
+ * A saída também mostra o erro da antiga cadeia de divisões por 100, para
+ * comparação.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "globals.h"
+#include "tables.h"
+
+// Globais e lookup de VE que o fuel.cpp usa do resto do firmware
+struct Statuses currentStatus;
+struct ConfigPage1 configPage1;
+struct ConfigPage2 configPage2;
+struct Table3D veTable;
+
+static int16_t stubVE = 0;
+
+int16_t getTableValue(struct Table3D*, uint8_t, uint16_t) {
+  return stubVE;
+}
+
+// Incluído direto: acesso ao cache das correções (static)
+#include "fuel.cpp"
+
+typedef unsigned __int128 u128;
+
+// ============================================================================
+// SORTEIO (xorshift64, semente fixa: execuções reproduzíveis)
+// ============================================================================
+
+static uint64_t rngState = 88172645463325252ULL;
+
+static uint32_t rnd(uint32_t n) {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return (uint32_t)(rngState % n);
+}
+
+// ============================================================================
+// COMPARAÇÃO
+// ============================================================================
+
+static long maxErr = 0;           // |novo - exato| máximo (us)
+static long maxErrOld = 0;        // |cadeia antiga - exato| máximo (us)
+static unsigned long long samples = 0;
+static unsigned long long failures = 0;
+
+static uint32_t clampPW(uint64_t pw) {
+  if (pw < INJ_MIN_PW) return INJ_MIN_PW;
+  if (pw > INJ_MAX_PW) return INJ_MAX_PW;
+  return (uint32_t)pw;
+}
+
+static void check(uint16_t req, uint8_t ve, uint16_t mapX10, uint8_t wue, uint8_t ase,
+                  uint8_t clt, uint8_t bat, uint8_t aePct, uint8_t injOpen) {
+  configPage1.reqFuel = req;
+  configPage1.injOpen = injOpen;
+  stubVE = ve;
+  currentStatus.MAPx10 = mapX10;
+
+  // Produto das correções multiplicativas direto no cache, com as chaves
+  // iguais ao status atual (WUE/CLT/bateria não dependem de tabela aqui)
+  corrProduct = (uint32_t)((uint16_t)wue * ase) * (uint16_t)((uint16_t)clt * bat);
+  corrCoolant = currentStatus.coolant;
+  corrBattery = currentStatus.battery10;
+  corrASE = correctionASE();
+  corrWarmup = BIT_CHECK(currentStatus.engineStatus, ENGINE_WARMUP) ? 1 : 0;
+  corrValid = true;
+
+  // AE pelo caminho real (correctionAE), acelerando sem "aceleração forte";
+  // fora do modo TPS o AE é zero
+  configPage1.aeMode = aePct ? AE_MODE_TPS : AE_MODE_MAP;
+  configPage1.aePct = 100 + aePct;
+  configPage1.aeThresh = 1;
+  currentStatus.TPSdot = 2;
+  uint8_t ae = correctionAE();
+
+  long got = calculateInjection();
+
+  // Exato: correções em 10^-6 %, limitadas como no firmware
+  uint64_t total = (uint64_t)wue * ase * clt * bat;
+  if (total > CORR_MAX * 1000000ULL) total = CORR_MAX * 1000000ULL;
+  total += ae * 1000000ULL;
+  if (total < CORR_MIN * 1000000ULL) total = CORR_MIN * 1000000ULL;
+  if (total > CORR_MAX * 1000000ULL) total = CORR_MAX * 1000000ULL;
+  u128 base = (u128)req * ve * mapX10 * total / (u128)10000000000000ULL;
+  long exact = clampPW((uint64_t)base + injOpen);
+
+  // Cadeia antiga: PERCENT() e /100, /1000 truncando a cada passo
+  uint32_t corr = 100;
+  corr = corr * wue / 100;
+  corr = corr * ase / 100;
+  corr = corr * clt / 100;
+  corr = corr * bat / 100;
+  corr += ae;
+  if (corr < CORR_MIN) corr = CORR_MIN;
+  if (corr > CORR_MAX) corr = CORR_MAX;
+  uint32_t pw = req;
+  pw = pw * ve / 100;
+  pw = pw * mapX10 / 1000;
+  pw = pw * corr / 100;
+  long old = clampPW((uint64_t)pw + injOpen);
+
+  long err = labs(got - exact);
+  if (err > 1) {
+    if (failures < 10) {
+      printf("FALHA: reqFuel=%u VE=%u MAPx10=%u corr=%u/%u/%u/%u AE=%u -> %ld us, exato %ld us\n",
+             req, ve, mapX10, wue, ase, clt, bat, ae, got, exact);
+    }
+    failures++;
+  }
+  if (err > maxErr) maxErr = err;
+  if (labs(old - exact) > maxErrOld) maxErrOld = labs(old - exact);
+  samples++;
+}
+
+// Correções sorteadas dentro das faixas que o firmware produz
+static void checkRandomCorrections(uint16_t req, uint8_t ve, uint16_t mapX10) {
+  static const uint8_t clts[] = {95, 96, 97, 98, 99, 100};
+  static const uint8_t bats[] = {97, 100, 105, 110};
+  check(req, ve, mapX10, 100 + rnd(156), 100 + rnd(156), clts[rnd(6)], bats[rnd(4)],
+        rnd(2) ? rnd(156) : 0, rnd(256));
+}
+
+int main() {
+  currentStatus.coolant = 90;
+  currentStatus.battery10 = 140;
+
+  // 1. Todo par VE x MAPx10
+  for (uint16_t ve = 0; ve <= 255; ve++) {
+    for (uint16_t mapX10 = 0; mapX10 <= 2550; mapX10++) {
+      for (uint8_t k = 0; k < 8; k++) {
+        checkRandomCorrections(rnd(65536), ve, mapX10);
+      }
+    }
+  }
+
+  // 2. Todo reqFuel
+  for (uint32_t req = 0; req <= 65535; req++) {
+    for (uint8_t k = 0; k < 8; k++) {
+      checkRandomCorrections(req, rnd(256), rnd(2551));
+    }
+  }
+
+  // 3. Extremos de cada entrada
+  static const uint16_t reqs[] = {0, 1, 999, 6500, 15000, 30000, 65535};
+  static const uint8_t ves[] = {0, 1, 50, 99, 100, 101, 254, 255};
+  static const uint16_t maps[] = {0, 1, 999, 1000, 1001, 2549, 2550};
+  static const uint8_t pcts[] = {0, 1, 50, 99, 100, 101, 200, 255};
+  static const uint8_t aes[] = {0, 1, 100, 155};
+  for (uint16_t req : reqs)
+    for (uint8_t ve : ves)
+      for (uint16_t mapX10 : maps)
+        for (uint8_t wue : pcts)
+          for (uint8_t ase : pcts)
+            for (uint8_t clt : pcts)
+              for (uint8_t bat : pcts)
+                for (uint8_t ae : aes)
+                  check(req, ve, mapX10, wue, ase, clt, bat, ae, 0);
+
+  printf("%llu casos: erro maximo %ld us (%llu acima de 1 us); cadeia antiga: %ld us\n",
+         samples, maxErr, failures, maxErrOld);
+  return failures ? 1 : 0;
+}